@@ -0,0 +1,68 @@
+// Copyright (c) 2021 - for information on the respective copyright owner
+// see the NOTICE file and/or the repository https://github.com/boschglobal/locator_ros_bridge.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <ios>
+#include <iostream>
+#include <vector>
+
+#include "rosmsgs_datagram_converter.hpp"
+
+/**
+ * Helpers for the libFuzzer targets of the datagram converters (enabled with the CMake option BUILD_FUZZERS).
+ * Time and memory per input are bounded by running the targets with e.g. -timeout=1 -rss_limit_mb=512
+ * -malloc_limit_mb=64, the targets additionally check that the decoded data is bounded by the input size.
+ */
+namespace datagram_fuzzer
+{
+/// abort (so that the fuzzer reports the input) if the given condition does not hold
+inline void check(bool condition, const char* description)
+{
+  if (!condition)
+  {
+    std::cerr << "check failed: " << description << std::endl;
+    std::abort();
+  }
+}
+
+/**
+ * @brief convert Runs the given conversion on the fuzzer input
+ * @return false if the datagram has been rejected (incomplete or corrupt), which is expected for most inputs
+ */
+inline bool convert(const uint8_t* data, size_t size, const std::function<size_t(const std::vector<char>&)>& conversion)
+{
+  const std::vector<char> datagram(data, data + size);
+  try
+  {
+    const size_t parsed_bytes = conversion(datagram);
+    check(parsed_bytes <= datagram.size(), "parsed bytes within datagram");
+    return true;
+  }
+  catch (const std::ios_base::failure&)
+  {
+    // incomplete datagram, ReceivingInterface::onReadEvent waits for more data
+    return false;
+  }
+  catch (const CorruptDatagramError&)
+  {
+    // ReceivingInterface::onReadEvent discards the stream, any other exception is reported by the fuzzer
+    return false;
+  }
+}
+}  // namespace datagram_fuzzer
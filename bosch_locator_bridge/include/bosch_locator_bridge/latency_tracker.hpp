@@ -0,0 +1,86 @@
+// Copyright (c) 2021 - for information on the respective copyright owner
+// see the NOTICE file and/or the repository https://github.com/boschglobal/locator_ros_bridge.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include <ros/ros.h>
+
+#include "bosch_locator_bridge/BridgeLatencyStatistics.h"
+
+/**
+ * Measures the time between milestones of the bridge, e.g. from its start or a seed until the locator reports to be
+ * localized. Every measured duration is published as BridgeLatencyEvent and summarized per interval in a latched
+ * BridgeLatencySummary.
+ */
+class LatencyTracker
+{
+public:
+  /// advertises the latency topics and takes the current time as start of the bridge
+  explicit LatencyTracker(ros::NodeHandle& nh);
+
+  /**
+   * @brief milestone Measures the time from the start of the bridge until the first occurrence of the given milestone
+   * as interval startup_to_<name>. Later occurrences are ignored.
+   */
+  void milestone(const std::string& name);
+
+  /**
+   * @brief start Starts the given interval, restarting it if it is already running
+   * @param await_sequence If set, the interval cannot be stopped until ignoreUntil() has been called for it
+   */
+  void start(const std::string& interval, bool await_sequence = false);
+
+  /**
+   * @brief ignoreUntil Lets the running interval only be stopped by events with a sequence number larger than the
+   * given one, e.g. to ignore localization poses sent before the request that started the interval took effect
+   */
+  void ignoreUntil(const std::string& interval, uint64_t sequence);
+
+  /**
+   * @brief stop Stops the given interval and publishes its duration. Does nothing if the interval is not running or
+   * the event is too old, see ignoreUntil()
+   * @param sequence Sequence number of the event stopping the interval
+   */
+  void stop(const std::string& interval, uint64_t sequence = std::numeric_limits<uint64_t>::max());
+
+  /// stop the given interval without publishing its duration, e.g. if the request that started it failed
+  void cancel(const std::string& interval);
+
+private:
+  /// publish the event and the updated summary, needs to be called with the mutex locked
+  void publish(const std::string& interval, const ros::WallTime& start, const ros::WallTime& end);
+
+  ros::Publisher event_pub_;
+  ros::Publisher summary_pub_;
+  const ros::WallTime startup_time_;
+
+  std::mutex mutex_;
+  //! milestones which occurred already
+  std::set<std::string> milestones_;
+  struct RunningInterval
+  {
+    ros::WallTime start;
+    //! only events with a larger sequence number stop the interval
+    uint64_t ignored_sequence{ 0 };
+  };
+  std::map<std::string, RunningInterval> running_intervals_;
+  std::map<std::string, bosch_locator_bridge::BridgeLatencyStatistics> statistics_;
+};
@@ -15,14 +15,21 @@
 
 #pragma once
 
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 
 #include <Poco/Thread.h>
 
+#include <actionlib/server/simple_action_server.h>
+#include <geometry_msgs/Pose2D.h>
 #include <geometry_msgs/PoseWithCovarianceStamped.h>
 #include <nav_msgs/Odometry.h>
 #include <ros/ros.h>
 #include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
 #include <std_srvs/Empty.h>
 
 #include "bosch_locator_bridge/ClientConfigGetEntry.h"
@@ -30,8 +37,12 @@
 #include "bosch_locator_bridge/ClientMapSend.h"
 #include "bosch_locator_bridge/ClientMapSet.h"
 #include "bosch_locator_bridge/ClientMapStart.h"
+#include "bosch_locator_bridge/MapWorkflowAction.h"
 #include "bosch_locator_bridge/StartRecording.h"
+#include "bosch_locator_bridge/SwitchModeAction.h"
+#include "latency_tracker.hpp"
 #include "locator_rpc_interface.hpp"
+#include "locator_state_monitor.hpp"
 
 // forward declarations
 class LocatorRPCInterface;
@@ -45,6 +56,8 @@ class ClientLocalizationMapInterface;
 class ClientLocalizationVisualizationInterface;
 class ClientLocalizationPoseInterface;
 class ClientGlobalAlignVisualizationInterface;
+class SeedCandidateScorer;
+class MapPrefetcher;
 
 /**
  * This is the main ROS node. It binds together the ROS interface and the Locator API.
@@ -75,6 +88,8 @@ private:
 
   bool clientMapSendCb(bosch_locator_bridge::ClientMapSend::Request& req,
                        bosch_locator_bridge::ClientMapSend::Response& res);
+  bool clientMapPrefetchCb(bosch_locator_bridge::ClientMapSend::Request& req,
+                           bosch_locator_bridge::ClientMapSend::Response& res);
   bool clientMapSetCb(bosch_locator_bridge::ClientMapSet::Request& req,
                       bosch_locator_bridge::ClientMapSet::Response& res);
   bool clientMapList(bosch_locator_bridge::ClientMapList::Request& req,
@@ -83,7 +98,10 @@ private:
   bool clientLocalizationStartCb(std_srvs::Empty::Request& req, std_srvs::Empty::Response& res);
   bool clientLocalizationStopCb(std_srvs::Empty::Request& req, std_srvs::Empty::Response& res);
 
+  void localizationMapCallback(const sensor_msgs::PointCloud2& map);
+
   void setSeedCallback(const geometry_msgs::PoseWithCovarianceStamped& msg);
+  void sendSeed(const geometry_msgs::Pose2D& pose);
 
   bool clientRecordingStartVisualRecordingCb(bosch_locator_bridge::StartRecording::Request& req,
                                              bosch_locator_bridge::StartRecording::Response& res);
@@ -93,6 +111,27 @@ private:
                         bosch_locator_bridge::ClientMapStart::Response& res);
   bool clientMapStopCb(std_srvs::Empty::Request& req, std_srvs::Empty::Response& res);
 
+  void switchModeCb(const bosch_locator_bridge::SwitchModeGoalConstPtr& goal);
+  void mapWorkflowCb(const bosch_locator_bridge::MapWorkflowGoalConstPtr& goal);
+  /**
+   * @brief triggerTransition Triggers the given SwitchModeGoal transition
+   * @param target_reached Set to the predicate for the target state of the transition [OUTPUT]
+   * @return false if the transition is unknown or has been rejected by the locator
+   */
+  bool triggerTransition(uint8_t transition, const std::string& recording_name, const std::string& client_map_name,
+                         LocatorStateMonitor::Predicate& target_reached);
+
+  /**
+   * @brief callTracked Calls the given RPC method. The given latency intervals have to be started before. If the call
+   * fails, they are cancelled, otherwise they ignore the localization poses received so far (see
+   * LatencyTracker::ignoreUntil())
+   * @return false if the call failed
+   */
+  bool callTracked(const std::string& method, const Poco::JSON::Object& query,
+                   std::initializer_list<std::string> intervals);
+  /// same as above for any RPC, which returns false if it failed
+  bool callTracked(const std::function<bool()>& rpc, std::initializer_list<std::string> intervals);
+
   /// read out ROS parameters and use them to update the locator config
   void syncConfig();
 
@@ -101,9 +140,35 @@ private:
                       const std::string& laser) const;
   void setupBinaryReceiverInterfaces(const std::string& host);
 
+  /// stop the mode switch intervals of all modes whose state changed with the given control mode
+  void trackControlModeLatency(const bosch_locator_bridge::ClientControlMode& control_mode);
+
   ros::NodeHandle nh_;
+  //! Measures startup, seed, map switch and mode switch latencies
+  LatencyTracker latency_tracker_;
+  //! previous control mode, to detect mode transitions (only accessed by the client control mode interface thread)
+  bosch_locator_bridge::ClientControlMode last_control_mode_;
+  bool control_mode_received_{ false };
+  //! whether the previous localization pose was localized, to detect a lost localization (only accessed by the
+  //! client localization pose interface thread)
+  bool localized_{ false };
   std::unique_ptr<LocatorRPCInterface> loc_client_interface_;
 
+  // The members below are used by the receiving interface threads and the action threads, so they are declared
+  // before (and therefore destroyed after) the interfaces and action servers.
+  std::string last_recording_name_;
+  std::string last_map_name_;
+
+  //! Sends maps to the map server in the background and caches decoded localization maps
+  std::unique_ptr<MapPrefetcher> map_prefetcher_;
+  //! active map and start of the latest map switch, to measure the time until its localization map is received
+  std::mutex map_switch_mutex_;
+  std::string active_map_name_;
+  ros::WallTime map_switch_start_;
+  bool map_switch_pending_{ false };
+  //! false while the locator has not yet confirmed the latest map switch, so a received map might be the previous one
+  bool map_switch_confirmed_{ true };
+
   ros::Timer session_refresh_timer_;
 
   std::vector<ros::ServiceServer> services_;
@@ -118,6 +183,17 @@ private:
   Poco::Thread laser2_sending_interface_thread_;
 
   ros::Subscriber set_seed_sub_;
+  //! Scores candidates around a requested seed (only if seed candidate scoring is enabled)
+  std::unique_ptr<SeedCandidateScorer> seed_candidate_scorer_;
+  //! number of best candidates to send in sequence until the locator reports to be localized
+  int seed_candidates_to_send_{ 1 };
+  ros::WallDuration seed_candidate_timeout_{ 2.0 };
+
+  //! Locator state as reported by the binary interfaces
+  LocatorStateMonitor state_monitor_;
+  //! Actions which trigger mode transitions and finish once the locator has reached the target state
+  std::unique_ptr<actionlib::SimpleActionServer<bosch_locator_bridge::SwitchModeAction>> switch_mode_server_;
+  std::unique_ptr<actionlib::SimpleActionServer<bosch_locator_bridge::MapWorkflowAction>> map_workflow_server_;
 
   // Flag to indicate if the bridge should send odometry data to the locator. Value retrieved by the locator settings.
   bool provide_laser_data_;
@@ -150,9 +226,6 @@ private:
   size_t scan2_num_{ 0 };
   size_t odom_num_{ 0 };
 
-  std::string last_recording_name_;
-  std::string last_map_name_;
-
   ros::Time prev_laser_timestamp_;
   ros::Time prev_laser2_timestamp_;
 };
@@ -0,0 +1,80 @@
+// Copyright (c) 2021 - for information on the respective copyright owner
+// see the NOTICE file and/or the repository https://github.com/boschglobal/locator_ros_bridge.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#include <ros/ros.h>
+
+#include "bosch_locator_bridge/ClientControlMode.h"
+#include "bosch_locator_bridge/ClientLocalizationPose.h"
+#include "bosch_locator_bridge/ClientMapVisualization.h"
+
+/**
+ * Keeps track of the locator state as reported by the binary interfaces and allows to wait for state changes without
+ * polling.
+ */
+class LocatorStateMonitor
+{
+public:
+  struct State
+  {
+    //! latest client control mode (only valid if control_mode_count > 0)
+    bosch_locator_bridge::ClientControlMode control_mode;
+    uint64_t control_mode_count{ 0 };
+    //! state of the latest localization pose (only valid if localization_pose_count > 0)
+    int32_t localization_state{ 0 };
+    uint64_t localization_pose_count{ 0 };
+    //! progress of the latest map visualization (only valid if map_visualization_count > 0)
+    double map_progress{ 0.0 };
+    uint64_t map_visualization_count{ 0 };
+  };
+
+  using Predicate = std::function<bool(const State&)>;
+  using UpdateCallback = std::function<void(const State&)>;
+
+  void updateControlMode(const bosch_locator_bridge::ClientControlMode& control_mode);
+  void updateLocalizationPose(const bosch_locator_bridge::ClientLocalizationPose& pose);
+  void updateMapVisualization(const bosch_locator_bridge::ClientMapVisualization& visualization);
+
+  State getState() const;
+
+  /**
+   * @brief waitFor Blocks until the given predicate holds for the current state
+   * @param done Predicate on the state to wait for (evaluated with the monitor locked, must not block)
+   * @param timeout Maximum time to wait, zero to wait without timeout
+   * @param interrupted Checked after every call to interrupt(), waiting is aborted if it returns true
+   * @param on_update Invoked with every state update while waiting (with the monitor unlocked)
+   * @return true if the predicate holds, false on timeout or interruption
+   */
+  bool waitFor(const Predicate& done, const ros::WallDuration& timeout,
+               const std::function<bool()>& interrupted = std::function<bool()>(),
+               const UpdateCallback& on_update = UpdateCallback());
+
+  /// wake up all waiting threads so that they evaluate their interrupted condition
+  void interrupt();
+
+private:
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  State state_;
+  //! incremented with every state update
+  uint64_t version_{ 0 };
+  //! incremented with every call to interrupt()
+  uint64_t interrupt_count_{ 0 };
+};
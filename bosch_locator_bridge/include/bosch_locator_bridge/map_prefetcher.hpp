@@ -0,0 +1,89 @@
+// Copyright (c) 2021 - for information on the respective copyright owner
+// see the NOTICE file and/or the repository https://github.com/boschglobal/locator_ros_bridge.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <sensor_msgs/PointCloud2.h>
+
+// forward declarations
+class LocatorRPCInterface;
+
+/**
+ * Sends client maps to the map server in the background, so that a later map switch only needs to set the active map.
+ * Also caches the decoded localization maps of previously used client maps, so they are available right after a
+ * switch. Uses its own RPC session, so that sending a map does not block the RPC calls of the bridge node.
+ */
+class MapPrefetcher
+{
+public:
+  MapPrefetcher(std::unique_ptr<LocatorRPCInterface> rpc_interface, size_t cache_size);
+  ~MapPrefetcher();
+
+  /// refresh the RPC session of the prefetcher
+  void refresh();
+
+  /**
+   * @brief prefetch Starts sending the given client map to the map server in the background
+   * @param client_map_name Name of the client map to send
+   * @return false if another map is currently being sent
+   */
+  bool prefetch(const std::string& client_map_name);
+
+  /**
+   * @brief waitForPrefetch Blocks while the given client map is being sent
+   * @param client_map_name Name of the client map
+   * @return false if the latest prefetch of the map has failed
+   */
+  bool waitForPrefetch(const std::string& client_map_name);
+
+  /// forget a failed prefetch of the given client map, because it has been sent to the map server otherwise
+  void markMapSent(const std::string& client_map_name);
+
+  /// store the decoded localization map of the given client map, evicting the least recently used one if necessary
+  void cacheMap(const std::string& client_map_name, const sensor_msgs::PointCloud2& map);
+
+  /// get the decoded localization map of the given client map. Returns false if it is not cached
+  bool getCachedMap(const std::string& client_map_name, sensor_msgs::PointCloud2& map);
+
+  /// remove the cached localization map of the given client map, e.g. because the client map is replaced
+  void removeCachedMap(const std::string& client_map_name);
+
+private:
+  void sendMap(const std::string& client_map_name);
+  /// needs to be called with the mutex locked
+  void removeCachedMapLocked(const std::string& client_map_name);
+
+  std::unique_ptr<LocatorRPCInterface> rpc_interface_;
+  std::thread prefetch_thread_;
+
+  std::mutex mutex_;
+  std::condition_variable prefetch_cv_;
+  //! name of the client map currently sent, empty if none
+  std::string prefetching_map_name_;
+  //! client maps whose latest prefetch has failed
+  std::set<std::string> failed_map_names_;
+
+  const size_t cache_size_;
+  //! decoded localization maps, most recently used first
+  std::list<std::pair<std::string, sensor_msgs::PointCloud2>> map_cache_;
+};
@@ -15,9 +15,17 @@
 
 #pragma once
 
+#include <functional>
+
 #include <ros/ros.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/PoseWithCovarianceStamped.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include "bosch_locator_bridge/ClientControlMode.h"
+#include "bosch_locator_bridge/ClientLocalizationPose.h"
+#include "bosch_locator_bridge/ClientLocalizationVisualization.h"
+#include "bosch_locator_bridge/ClientMapVisualization.h"
 
 #include <Poco/Net/SocketReactor.h>
 #include <Poco/Net/StreamSocket.h>
@@ -31,7 +39,12 @@
 class ReceivingInterface : public Poco::Runnable
 {
 public:
-  ReceivingInterface(const Poco::Net::IPAddress& hostadress, Poco::UInt16 port, ros::NodeHandle& nh);
+  /**
+   * @param max_datagram_size Upper bound for the data described by a single length field of the received datagrams.
+   * Corrupt datagrams exceeding it are discarded right away instead of being buffered until enough data has arrived.
+   */
+  ReceivingInterface(const Poco::Net::IPAddress& hostadress, Poco::UInt16 port, ros::NodeHandle& nh,
+                     size_t max_datagram_size);
 
   virtual ~ReceivingInterface();
 
@@ -39,6 +52,12 @@ public:
 
   void run();
 
+  using FirstDatagramCallback = std::function<void()>;
+
+  /// Invoke the given callback once the first datagram has been parsed. Must be set before the interface thread is
+  /// started.
+  void setFirstDatagramCallback(const FirstDatagramCallback& callback);
+
 protected:
   /**
    * @brief Actual function to be overwritten by child to handle data, e.g., convert to ros messages and
@@ -54,6 +73,9 @@ protected:
   //! Node handle
   ros::NodeHandle nh_;
 
+  //! to be passed to the datagram converters
+  const size_t max_datagram_size_;
+
   // port definitions for the different interfaces. See Locator API documentation section 12.8
   static constexpr Poco::UInt16 BINARY_CLIENT_CONTROL_MODE_PORT{ 9004 };
   static constexpr Poco::UInt16 BINARY_CLIENT_MAP_MAP_PORT{ 9005 };
@@ -70,13 +92,24 @@ private:
   Poco::Net::SocketReactor reactor_;
   // TODO use a better suited data structure (a deque?)
   std::vector<char> datagram_buffer_;
+  FirstDatagramCallback first_datagram_callback_;
+  bool first_datagram_parsed_{ false };
 };
 
 class ClientControlModeInterface : public ReceivingInterface
 {
 public:
+  using ControlModeCallback = std::function<void(const bosch_locator_bridge::ClientControlMode&)>;
+
   ClientControlModeInterface(const Poco::Net::IPAddress& hostadress, ros::NodeHandle& nh);
   size_t tryToParseData(const std::vector<char>& datagram) override;
+
+  /// Additionally hand every received control mode to the given callback. Must be set before the interface thread is
+  /// started.
+  void setControlModeCallback(const ControlModeCallback& callback);
+
+private:
+  ControlModeCallback control_mode_callback_;
 };
 
 class ClientMapMapInterface : public ReceivingInterface
@@ -89,8 +122,17 @@ public:
 class ClientMapVisualizationInterface : public ReceivingInterface
 {
 public:
+  using VisualizationCallback = std::function<void(const bosch_locator_bridge::ClientMapVisualization&)>;
+
   ClientMapVisualizationInterface(const Poco::Net::IPAddress& hostadress, ros::NodeHandle& nh);
   size_t tryToParseData(const std::vector<char>& datagram) override;
+
+  /// Additionally hand every received visualization to the given callback. Must be set before the interface thread is
+  /// started.
+  void setVisualizationCallback(const VisualizationCallback& callback);
+
+private:
+  VisualizationCallback visualization_callback_;
 };
 
 class ClientRecordingMapInterface : public ReceivingInterface
@@ -110,22 +152,52 @@ public:
 class ClientLocalizationMapInterface : public ReceivingInterface
 {
 public:
+  using MapCallback = std::function<void(const sensor_msgs::PointCloud2&)>;
+
   ClientLocalizationMapInterface(const Poco::Net::IPAddress& hostadress, ros::NodeHandle& nh);
   size_t tryToParseData(const std::vector<char>& datagram) override;
+
+  /// Additionally hand every received map to the given callback. Must be set before the interface thread is started.
+  void setMapCallback(const MapCallback& callback);
+
+  /// Publish a map which has not been received via the binary interface, e.g. a cached one
+  void publishMap(const sensor_msgs::PointCloud2& map);
+
+private:
+  MapCallback map_callback_;
 };
 
 class ClientLocalizationVisualizationInterface : public ReceivingInterface
 {
 public:
+  using VisualizationCallback =
+      std::function<void(const bosch_locator_bridge::ClientLocalizationVisualization&,
+                         const geometry_msgs::PoseStamped&, const sensor_msgs::PointCloud2&)>;
+
   ClientLocalizationVisualizationInterface(const Poco::Net::IPAddress& hostadress, ros::NodeHandle& nh);
   size_t tryToParseData(const std::vector<char>& datagram) override;
+
+  /// Additionally hand every received visualization to the given callback. Must be set before the interface thread is
+  /// started.
+  void setVisualizationCallback(const VisualizationCallback& callback);
+
+private:
+  VisualizationCallback visualization_callback_;
 };
 
 class ClientLocalizationPoseInterface : public ReceivingInterface
 {
 public:
+  using PoseCallback = std::function<void(const bosch_locator_bridge::ClientLocalizationPose&)>;
+
   ClientLocalizationPoseInterface(const Poco::Net::IPAddress& hostadress, ros::NodeHandle& nh);
   size_t tryToParseData(const std::vector<char>& datagram) override;
+
+  /// Additionally hand every received pose to the given callback. Must be set before the interface thread is started.
+  void setPoseCallback(const PoseCallback& callback);
+
+private:
+  PoseCallback pose_callback_;
 };
 
 class ClientGlobalAlignVisualizationInterface : public ReceivingInterface
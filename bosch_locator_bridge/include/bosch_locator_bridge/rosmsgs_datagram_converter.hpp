@@ -36,15 +36,37 @@
 #include <Poco/BinaryReader.h>
 #include <Poco/JSON/Object.h>
 
+#include <stdexcept>
+
 #define MAP_FRAME_ID "map"
 #define ODOM_FRAME_ID "odom"
 
+/**
+ * Thrown if a received datagram is corrupt, e.g. because of an implausible length field or a timestamp out of range.
+ * The stream containing it cannot be resynchronized.
+ */
+class CorruptDatagramError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
 /**
  * Class with static function to convert ros messages to locator's datagrams.
  */
 class RosMsgsDatagramConverter
 {
 public:
+  /**
+   * Upper bounds for the data described by a single length field of a received datagram. Datagrams with larger length
+   * fields are rejected with CorruptDatagramError, so corrupt data cannot trigger huge allocations or stall the stream
+   * while waiting for data that never arrives. Only maps need the large bound.
+   */
+  static constexpr size_t MAX_DATAGRAM_SIZE{ 256u * 1024u * 1024u };
+  static constexpr size_t MAX_VISUALIZATION_DATAGRAM_SIZE{ 32u * 1024u * 1024u };
+  //! control mode and pose datagrams have a fixed size of a few hundred bytes
+  static constexpr size_t MAX_STATE_DATAGRAM_SIZE{ 64u * 1024u };
+
   /**
    * @brief convertClientControlMode2Message
    * @param datagram The binary data input datagram [INPUT]
@@ -60,10 +82,12 @@ public:
    * @param datagram The binary data input datagram [INPUT]
    * @param stamp ROS timestamp to assign to the message [INPUT]
    * @param out_pointcloud Resulting converted map as point cloud [OUTPUT]
+   * @param max_datagram_size Upper bound for the data described by a single length field [INPUT]
    * @return number of bytes parsed successfully
    */
   static size_t convertMapDatagram2Message(const std::vector<char>& datagram, const ros::Time& stamp,
-                                           sensor_msgs::PointCloud2& out_pointcloud);
+                                           sensor_msgs::PointCloud2& out_pointcloud,
+                                           size_t max_datagram_size = MAX_DATAGRAM_SIZE);
 
   /**
    * @brief convertClientGlobalAlignVisualizationDatagram2Message
@@ -72,12 +96,14 @@ public:
    * @param poses A set of poses previously visited by the platform. The platform may have observed landmarks from some
    * of these poses [OUTPUT]
    * @param landmark_poses The array of poses according to the landmarks [OUTPUT]
+   * @param max_datagram_size Upper bound for the data described by a single length field [INPUT]
    * @return number of bytes parsed successfully
    */
   static size_t convertClientGlobalAlignVisualizationDatagram2Message(
       const std::vector<char>& datagram,
       bosch_locator_bridge::ClientGlobalAlignVisualization& client_global_align_visualization,
-      geometry_msgs::PoseArray& poses, geometry_msgs::PoseArray& landmark_poses);
+      geometry_msgs::PoseArray& poses, geometry_msgs::PoseArray& landmark_poses,
+      size_t max_datagram_size = MAX_VISUALIZATION_DATAGRAM_SIZE);
 
   /**
    * @brief convertClientLocalizationPoseDatagram2Message
@@ -98,12 +124,14 @@ public:
    * @param client_localization_visualization ClientLocalizationVisualization message [OUTPUT]
    * @param pose Pose message [OUTPUT]
    * @param scan Scan message [OUTPUT]
+   * @param max_datagram_size Upper bound for the data described by a single length field [INPUT]
    * @return number of bytes parsed successfully
    */
   static size_t convertClientLocalizationVisualizationDatagram2Message(
       const std::vector<char>& datagram,
       bosch_locator_bridge::ClientLocalizationVisualization& client_localization_visualization,
-      geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan);
+      geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan,
+      size_t max_datagram_size = MAX_VISUALIZATION_DATAGRAM_SIZE);
 
   /**
    * @brief convertClientMapVisualizationDatagram2Message
@@ -112,11 +140,13 @@ public:
    * @param pose Pose message [OUTPUT]
    * @param scan Scan message [OUTPUT]
    * @param path_poses PathPoses message [OUTPUT]
+   * @param max_datagram_size Upper bound for the data described by a single length field [INPUT]
    * @return number of bytes parsed successfully
    */
   static size_t convertClientMapVisualizationDatagram2Message(
       const std::vector<char>& datagram, bosch_locator_bridge::ClientMapVisualization& client_map_visualization,
-      geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan, geometry_msgs::PoseArray& path_poses);
+      geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan, geometry_msgs::PoseArray& path_poses,
+      size_t max_datagram_size = MAX_VISUALIZATION_DATAGRAM_SIZE);
 
   /**
    * @brief convertClientRecordingVisualizationDatagram2Message
@@ -125,12 +155,14 @@ public:
    * @param pose Pose message [OUTPUT]
    * @param scan Scan message [OUTPUT]
    * @param path_poses PathPoses message [OUTPUT]
+   * @param max_datagram_size Upper bound for the data described by a single length field [INPUT]
    * @return number of bytes parsed successfully
    */
   static size_t convertClientRecordingVisualizationDatagram2Message(
       const std::vector<char>& datagram,
       bosch_locator_bridge::ClientRecordingVisualization& client_recording_visualization,
-      geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan, geometry_msgs::PoseArray& path_poses);
+      geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan, geometry_msgs::PoseArray& path_poses,
+      size_t max_datagram_size = MAX_VISUALIZATION_DATAGRAM_SIZE);
 
   /**
    * @brief convertPose2DDoubleDatagram2Message Takes a binary_reader with a DOUBLE precision pose datagram coming next
@@ -173,14 +205,27 @@ public:
 
 private:
   static size_t convertMapDatagram2Message(Poco::BinaryReader& binary_reader, const ros::Time& stamp,
-                                           sensor_msgs::PointCloud2& out_pointcloud);
+                                           sensor_msgs::PointCloud2& out_pointcloud, size_t max_datagram_size);
   static size_t convertMapDatagram2PointCloud(Poco::BinaryReader& binary_reader,
-                                              pcl::PointCloud<pcl::PointXYZRGB>& out_pointcloud);
+                                              pcl::PointCloud<pcl::PointXYZRGB>& out_pointcloud,
+                                              size_t max_datagram_size);
   static void colorizePointCloud(pcl::PointCloud<pcl::PointXYZRGB>& point_cloud,
                                  const std::vector<uint64_t>& sensor_offsets);
-  static size_t discardExtension(Poco::BinaryReader& binary_reader);
-  static void readIntensities(Poco::BinaryReader& binary_reader);
-  static std::vector<uint64_t> readSensorOffsets(Poco::BinaryReader& binary_reader);
+  static size_t discardExtension(Poco::BinaryReader& binary_reader, size_t max_datagram_size);
+  static void readIntensities(Poco::BinaryReader& binary_reader, size_t max_datagram_size);
+  static std::vector<uint64_t> readSensorOffsets(Poco::BinaryReader& binary_reader, size_t max_datagram_size);
+
+  /**
+   * @brief checkAvailable Checks that the given number of elements can be read before anything is allocated for them
+   * @throw CorruptDatagramError if the elements do not fit into a datagram of max_datagram_size
+   * @throw std::ios_base::failure if the elements are not yet completely available
+   */
+  static void checkAvailable(Poco::BinaryReader& binary_reader, uint64_t num_elements, size_t element_size,
+                             size_t max_datagram_size);
+
+  /// convert a timestamp or duration of a datagram, throws CorruptDatagramError if it is out of range
+  static ros::Time toTime(double seconds);
+  static ros::Duration toDuration(double seconds);
 
   /// clamp scan data to specified range
   static float clamp_range(float r, float min, float max)
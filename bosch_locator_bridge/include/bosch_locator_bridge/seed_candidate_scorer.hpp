@@ -0,0 +1,113 @@
+// Copyright (c) 2021 - for information on the respective copyright owner
+// see the NOTICE file and/or the repository https://github.com/boschglobal/locator_ros_bridge.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/Pose2D.h>
+#include <sensor_msgs/PointCloud2.h>
+
+/**
+ * Samples candidate seed poses around a requested seed and scores them against a distance transform of the
+ * localization map, using the most recent scan of the localization visualization.
+ */
+class SeedCandidateScorer
+{
+public:
+  struct Parameters
+  {
+    //! candidates are sampled within [-linear_range, linear_range] around the seed [m]
+    double linear_range{ 0.5 };
+    double linear_step{ 0.1 };
+    //! candidates are sampled within [-angular_range, angular_range] around the seed [rad]
+    double angular_range{ 0.35 };
+    double angular_step{ 0.05 };
+    //! cell size of the distance transform [m]
+    double grid_resolution{ 0.05 };
+    //! distances to the map are truncated to this value [m]
+    double max_distance{ 1.0 };
+    //! the scan is subsampled to at most this number of points before scoring
+    int max_scan_points{ 360 };
+  };
+
+  struct Candidate
+  {
+    geometry_msgs::Pose2D pose;
+    //! mean truncated distance of the scan points to the map [m], smaller is better
+    double score;
+  };
+
+  explicit SeedCandidateScorer(const Parameters& parameters);
+  ~SeedCandidateScorer();
+
+  /// build the distance transform of the given localization map (in map frame) in the background
+  void setMap(const sensor_msgs::PointCloud2& map);
+
+  /// store the given scan (in map frame) relative to the pose it was taken from
+  void setScan(const geometry_msgs::Pose& pose, const sensor_msgs::PointCloud2& scan);
+
+  /**
+   * @brief scoreCandidates Scores all candidates around the given seed in parallel
+   * @param seed The seed pose requested by the operator
+   * @param max_candidates Maximum number of candidates to return. Candidates within half the linear and angular range
+   * of a better one are suppressed, so that the returned candidates are distinct hypotheses
+   * @return the candidates, sorted from best to worst score (empty if not ready)
+   */
+  std::vector<Candidate> scoreCandidates(const geometry_msgs::Pose2D& seed, size_t max_candidates) const;
+
+private:
+  struct Point
+  {
+    double x;
+    double y;
+  };
+
+  struct DistanceGrid
+  {
+    double origin_x;
+    double origin_y;
+    double resolution;
+    int width;
+    int height;
+    //! truncated euclidean distance [m] to the closest map point, row major
+    std::vector<float> distances;
+  };
+
+  static std::vector<Point> readPoints(const sensor_msgs::PointCloud2& cloud);
+  static std::shared_ptr<const DistanceGrid> computeDistanceGrid(const std::vector<Point>& points,
+                                                                 const Parameters& parameters);
+  static double scoreCandidate(const DistanceGrid& grid, const std::vector<Point>& scan,
+                               const geometry_msgs::Pose2D& pose, double max_distance);
+  /// computes the distance transform of the latest map passed to setMap()
+  void runDistanceGridWorker();
+
+  const Parameters parameters_;
+
+  mutable std::mutex mutex_;
+  std::shared_ptr<const DistanceGrid> grid_;
+  //! map points waiting for the distance transform worker, null if none
+  std::shared_ptr<const std::vector<Point>> pending_map_points_;
+  std::condition_variable worker_cv_;
+  bool stop_worker_{ false };
+  std::thread worker_;
+  //! points of the latest scan, relative to the pose it was taken from
+  std::shared_ptr<const std::vector<Point>> scan_;
+};
@@ -16,7 +16,10 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <deque>
 #include <mutex>
+#include <vector>
 
 #include <Poco/Net/ServerSocket.h>
 #include <Poco/Net/StreamSocket.h>
@@ -27,7 +30,12 @@
 class SendingInterface : public Poco::Runnable
 {
 public:
-  SendingInterface(uint16_t port);
+  /**
+   * @param port The port to listen on for connections
+   * @param replay_buffer_size Number of most recently sent data blobs to replay to newly accepted connections
+   * @param replay_max_age Only data blobs sent within this time [s] are replayed (0: no limit)
+   */
+  SendingInterface(uint16_t port, size_t replay_buffer_size = 0, double replay_max_age = 0.0);
   void run();
   virtual ~SendingInterface();
 
@@ -41,8 +49,19 @@ public:
   void stop();
 
 private:
+  /// send the given data blob completely to the given connection. Returns false if it could not be sent completely
+  static bool sendCompletely(Poco::Net::StreamSocket& connection, const char* data, size_t size);
+
+  /// send the buffered data blobs to a newly accepted connection, before it receives live data
+  bool replay(Poco::Net::StreamSocket& connection);
+
   std::mutex connections_mutex_;
   Poco::Net::ServerSocket socket_;
   std::atomic<bool> running_;
   std::vector<Poco::Net::StreamSocket> connections_;
+
+  //! recently sent data blobs with their sending time, oldest first (guarded by connections_mutex_)
+  std::deque<std::pair<std::chrono::steady_clock::time_point, std::vector<char>>> replay_buffer_;
+  const size_t replay_buffer_size_;
+  const std::chrono::duration<double> replay_max_age_;
 };
@@ -0,0 +1,34 @@
+// Copyright (c) 2021 - for information on the respective copyright owner
+// see the NOTICE file and/or the repository https://github.com/boschglobal/locator_ros_bridge.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fuzz/datagram_fuzzer.hpp"
+#include "rosmsgs_datagram_converter.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  bosch_locator_bridge::ClientGlobalAlignVisualization visualization;
+  geometry_msgs::PoseArray poses;
+  geometry_msgs::PoseArray landmark_poses;
+  if (datagram_fuzzer::convert(data, size, [&](const std::vector<char>& datagram) {
+        return RosMsgsDatagramConverter::convertClientGlobalAlignVisualizationDatagram2Message(
+            datagram, visualization, poses, landmark_poses);
+      }))
+  {
+    datagram_fuzzer::check(poses.poses.size() <= size / 12, "poses bounded by input");
+    datagram_fuzzer::check(landmark_poses.poses.size() <= size / 25, "landmarks bounded by input");
+    datagram_fuzzer::check(visualization.observations.size() <= size / 8, "observations bounded by input");
+  }
+  return 0;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2021 - for information on the respective copyright owner
+// see the NOTICE file and/or the repository https://github.com/boschglobal/locator_ros_bridge.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "latency_tracker.hpp"
+
+#include <algorithm>
+
+#include "bosch_locator_bridge/BridgeLatencyEvent.h"
+#include "bosch_locator_bridge/BridgeLatencySummary.h"
+
+LatencyTracker::LatencyTracker(ros::NodeHandle& nh) : startup_time_(ros::WallTime::now())
+{
+  event_pub_ = nh.advertise<bosch_locator_bridge::BridgeLatencyEvent>("latency/events", 10);
+  summary_pub_ = nh.advertise<bosch_locator_bridge::BridgeLatencySummary>("latency/summary", 1, true);
+}
+
+void LatencyTracker::milestone(const std::string& name)
+{
+  const auto now = ros::WallTime::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (milestones_.insert(name).second)
+  {
+    publish("startup_to_" + name, startup_time_, now);
+  }
+}
+
+void LatencyTracker::start(const std::string& interval, bool await_sequence)
+{
+  const auto now = ros::WallTime::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_intervals_[interval] =
+      RunningInterval{ now, await_sequence ? std::numeric_limits<uint64_t>::max() : 0 };
+}
+
+void LatencyTracker::ignoreUntil(const std::string& interval, uint64_t sequence)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto iter = running_intervals_.find(interval);
+  if (iter != running_intervals_.end())
+  {
+    iter->second.ignored_sequence = sequence;
+  }
+}
+
+void LatencyTracker::stop(const std::string& interval, uint64_t sequence)
+{
+  const auto now = ros::WallTime::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto iter = running_intervals_.find(interval);
+  if (iter != running_intervals_.end() && sequence > iter->second.ignored_sequence)
+  {
+    publish(interval, iter->second.start, now);
+    running_intervals_.erase(iter);
+  }
+}
+
+void LatencyTracker::cancel(const std::string& interval)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_intervals_.erase(interval);
+}
+
+void LatencyTracker::publish(const std::string& interval, const ros::WallTime& start, const ros::WallTime& end)
+{
+  const double duration = (end - start).toSec();
+  ROS_INFO_STREAM("latency " << interval << ": " << duration << "s");
+
+  bosch_locator_bridge::BridgeLatencyEvent event;
+  event.stamp = ros::Time::now();
+  event.interval = interval;
+  event.duration = duration;
+  event_pub_.publish(event);
+
+  auto& statistics = statistics_[interval];
+  statistics.interval = interval;
+  statistics.count++;
+  statistics.last = duration;
+  statistics.min = statistics.count == 1 ? duration : std::min(statistics.min, duration);
+  statistics.max = statistics.count == 1 ? duration : std::max(statistics.max, duration);
+  statistics.mean += (duration - statistics.mean) / statistics.count;
+
+  bosch_locator_bridge::BridgeLatencySummary summary;
+  summary.stamp = event.stamp;
+  for (const auto& entry : statistics_)
+  {
+    summary.intervals.push_back(entry.second);
+  }
+  summary_pub_.publish(summary);
+}
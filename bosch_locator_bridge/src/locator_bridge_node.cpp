@@ -15,9 +15,11 @@
 
 #include "locator_bridge_node.hpp"
 
+#include "map_prefetcher.hpp"
 #include "sending_interface.hpp"
 #include "receiving_interface.hpp"
 #include "rosmsgs_datagram_converter.hpp"
+#include "seed_candidate_scorer.hpp"
 
 #include <tf2/LinearMath/Transform.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
@@ -47,12 +49,18 @@ static const std::unordered_map<std::string, std::pair<int32_t, int32_t>> REQUIR
 //  {"ClientExpandMap", {2, 0}},
 });
 
-LocatorBridgeNode::LocatorBridgeNode() : nh_("~")
+LocatorBridgeNode::LocatorBridgeNode() : nh_("~"), latency_tracker_(nh_)
 {
 }
 
 LocatorBridgeNode::~LocatorBridgeNode()
 {
+  // let running actions notice the shutdown, so that their threads can be joined
+  state_monitor_.interrupt();
+  // join the action threads while the interfaces and members they use still exist
+  switch_mode_server_.reset();
+  map_workflow_server_.reset();
+
   laser_sending_interface_->stop();
   laser_sending_interface_thread_.join();
 
@@ -82,9 +90,18 @@ void LocatorBridgeNode::init()
   // Same thing is likely needed for the map server
   loc_client_interface_.reset(new LocatorRPCInterface(host, 8080));
   loc_client_interface_->login(user, pwd);
+  latency_tracker_.milestone("login");
+  // Maps are prefetched via a separate session, so that sending them does not block other calls
+  std::unique_ptr<LocatorRPCInterface> map_prefetch_interface(new LocatorRPCInterface(host, 8080));
+  map_prefetch_interface->login(user, pwd);
+  int map_cache_size = 3;
+  nh_.param("map_cache_size", map_cache_size, map_cache_size);
+  map_prefetcher_.reset(new MapPrefetcher(std::move(map_prefetch_interface), std::max(0, map_cache_size)));
+
   session_refresh_timer_ = nh_.createTimer(ros::Duration(30.), [&](const ros::TimerEvent&) {
     ROS_INFO_STREAM("refreshing session!");
     loc_client_interface_->refresh();
+    map_prefetcher_->refresh();
   });
 
   const auto module_versions = loc_client_interface_->getAboutModules();
@@ -94,6 +111,8 @@ void LocatorBridgeNode::init()
   }
 
   syncConfig();
+  get_config_entry("ClientLocalization.activeMapName", active_map_name_);
+  latency_tracker_.milestone("config_synced");
 
   services_.push_back(
       nh_.advertiseService("get_config_entry", &LocatorBridgeNode::clientConfigGetEntryCb, this));
@@ -110,19 +129,49 @@ void LocatorBridgeNode::init()
   services_.push_back(nh_.advertiseService("stop_localization", &LocatorBridgeNode::clientLocalizationStopCb, this));
 
   services_.push_back(nh_.advertiseService("send_map", &LocatorBridgeNode::clientMapSendCb, this));
+  services_.push_back(nh_.advertiseService("prefetch_map", &LocatorBridgeNode::clientMapPrefetchCb, this));
   services_.push_back(nh_.advertiseService("set_map", &LocatorBridgeNode::clientMapSetCb, this));
   services_.push_back(nh_.advertiseService("list_client_maps", &LocatorBridgeNode::clientMapList, this));
 
+  // Optionally refine seeds by scoring candidates around them against the localization map
+  bool enable_seed_candidate_scoring = false;
+  nh_.param("seed_candidate_scoring/enable", enable_seed_candidate_scoring, false);
+  if (enable_seed_candidate_scoring)
+  {
+    SeedCandidateScorer::Parameters parameters;
+    nh_.param("seed_candidate_scoring/linear_range", parameters.linear_range, parameters.linear_range);
+    nh_.param("seed_candidate_scoring/linear_step", parameters.linear_step, parameters.linear_step);
+    nh_.param("seed_candidate_scoring/angular_range", parameters.angular_range, parameters.angular_range);
+    nh_.param("seed_candidate_scoring/angular_step", parameters.angular_step, parameters.angular_step);
+    nh_.param("seed_candidate_scoring/grid_resolution", parameters.grid_resolution, parameters.grid_resolution);
+    nh_.param("seed_candidate_scoring/max_distance", parameters.max_distance, parameters.max_distance);
+    nh_.param("seed_candidate_scoring/max_scan_points", parameters.max_scan_points, parameters.max_scan_points);
+    nh_.param("seed_candidate_scoring/candidates_to_send", seed_candidates_to_send_, seed_candidates_to_send_);
+    double candidate_timeout = seed_candidate_timeout_.toSec();
+    nh_.param("seed_candidate_scoring/candidate_timeout", candidate_timeout, candidate_timeout);
+    seed_candidate_timeout_ = ros::WallDuration(candidate_timeout);
+    seed_candidate_scorer_.reset(new SeedCandidateScorer(parameters));
+  }
+
   // subscribe to default topic published by rviz "2D Pose Estimate" button for setting seed
   set_seed_sub_ = nh_.subscribe("/initialpose", 1, &LocatorBridgeNode::setSeedCallback, this);
 
+  // Recently sent data is replayed to the locator when it (re)connects, so that it does not start without history
+  bool laser_replay_last_scan = false;
+  nh_.param("laser_replay_last_scan", laser_replay_last_scan, false);
+  int odom_replay_buffer_size = 100;
+  nh_.param("odom_replay_buffer_size", odom_replay_buffer_size, odom_replay_buffer_size);
+  double replay_max_age = 2.0;
+  nh_.param("replay_max_age", replay_max_age, replay_max_age);
+
   // Create interface to send binary laser data if requested
   if (provide_laser_data_)
   {
     int laser_datagram_port;
     nh_.getParam("laser_datagram_port", laser_datagram_port);
 
-    laser_sending_interface_.reset(new SendingInterface(laser_datagram_port));
+    laser_sending_interface_.reset(
+        new SendingInterface(laser_datagram_port, laser_replay_last_scan ? 1 : 0, replay_max_age));
     laser_sending_interface_thread_.start(*laser_sending_interface_);
     // Create subscriber to laser data
     std::string scan_topic = "";
@@ -136,7 +185,8 @@ void LocatorBridgeNode::init()
     int laser2_datagram_port;
     nh_.getParam("laser2_datagram_port", laser2_datagram_port);
 
-    laser2_sending_interface_.reset(new SendingInterface(laser2_datagram_port));
+    laser2_sending_interface_.reset(
+        new SendingInterface(laser2_datagram_port, laser_replay_last_scan ? 1 : 0, replay_max_age));
     laser2_sending_interface_thread_.start(*laser2_sending_interface_);
     // Create subscriber to laser2 data
     std::string scan2_topic = "";
@@ -150,7 +200,8 @@ void LocatorBridgeNode::init()
     int odom_datagram_port;
     nh_.getParam("odom_datagram_port", odom_datagram_port);
 
-    odom_sending_interface_.reset(new SendingInterface(odom_datagram_port));
+    odom_sending_interface_.reset(
+        new SendingInterface(odom_datagram_port, std::max(0, odom_replay_buffer_size), replay_max_age));
     odom_sending_interface_thread_.start(*odom_sending_interface_);
     // Create subscriber to odometry data
     std::string odom_topic = "/odom";
@@ -160,6 +211,19 @@ void LocatorBridgeNode::init()
 
   setupBinaryReceiverInterfaces(host);
 
+  // Actions are driven by the state reported via the binary interfaces, so they are started afterwards
+  switch_mode_server_.reset(new actionlib::SimpleActionServer<bosch_locator_bridge::SwitchModeAction>(
+      nh_, "switch_mode",
+      [this](const bosch_locator_bridge::SwitchModeGoalConstPtr& goal) { switchModeCb(goal); }, false));
+  switch_mode_server_->registerPreemptCallback([this]() { state_monitor_.interrupt(); });
+  switch_mode_server_->start();
+  map_workflow_server_.reset(new actionlib::SimpleActionServer<bosch_locator_bridge::MapWorkflowAction>(
+      nh_, "map_workflow",
+      [this](const bosch_locator_bridge::MapWorkflowGoalConstPtr& goal) { mapWorkflowCb(goal); }, false));
+  map_workflow_server_->registerPreemptCallback([this]() { state_monitor_.interrupt(); });
+  map_workflow_server_->start();
+
+  latency_tracker_.milestone("initialized");
   ROS_INFO_STREAM("initialization done");
 }
 
@@ -252,20 +316,83 @@ bool LocatorBridgeNode::clientMapSendCb(bosch_locator_bridge::ClientMapSend::Req
 {
   const std::string client_map_name = req.name.empty() ? last_map_name_ : req.name;
 
+  // the map server might get a different map of the same name
+  map_prefetcher_->removeCachedMap(client_map_name);
+
   auto query = loc_client_interface_->getSessionQuery();
   query.set("clientMapName", client_map_name);
   auto response = loc_client_interface_->call("clientMapSend", query);
+  // call() returns an empty object if the RPC failed
+  if (!response.has("responseCode"))
+  {
+    return false;
+  }
+  map_prefetcher_->markMapSent(client_map_name);
   return true;
 }
 
+bool LocatorBridgeNode::clientMapPrefetchCb(bosch_locator_bridge::ClientMapSend::Request& req,
+                                            bosch_locator_bridge::ClientMapSend::Response& res)
+{
+  const std::string client_map_name = req.name.empty() ? last_map_name_ : req.name;
+  return map_prefetcher_->prefetch(client_map_name);
+}
+
 bool LocatorBridgeNode::clientMapSetCb(bosch_locator_bridge::ClientMapSet::Request& req,
                                        bosch_locator_bridge::ClientMapSet::Response& res)
 {
+  const auto start = ros::WallTime::now();
   const std::string active_map_name = req.name.empty() ? last_map_name_ : req.name;
 
+  // a map still being prefetched can only be set once it has arrived at the map server
+  if (!map_prefetcher_->waitForPrefetch(active_map_name))
+  {
+    ROS_WARN_STREAM("not setting map " << active_map_name << ", its latest prefetch failed. Send it again first.");
+    return false;
+  }
+
+  // the localization map might arrive before setConfigList returns, so the switch is registered beforehand
+  std::string previous_map_name;
+  {
+    std::lock_guard<std::mutex> lock(map_switch_mutex_);
+    previous_map_name = active_map_name_;
+    active_map_name_ = active_map_name;
+    map_switch_start_ = start;
+    map_switch_pending_ = true;
+    map_switch_confirmed_ = false;
+  }
+  latency_tracker_.start("map_switch_to_localization_map");
+  latency_tracker_.start("map_switch_to_localized", true);
+
   Poco::DynamicStruct config;
   config.insert("ClientLocalization.activeMapName", active_map_name);
-  loc_client_interface_->setConfigList(config);
+  const bool success = callTracked([&]() { return loc_client_interface_->setConfigList(config); },
+                                   { "map_switch_to_localization_map", "map_switch_to_localized" });
+  {
+    std::lock_guard<std::mutex> lock(map_switch_mutex_);
+    if (!success)
+    {
+      active_map_name_ = previous_map_name;
+      map_switch_pending_ = false;
+    }
+    map_switch_confirmed_ = true;
+  }
+  if (!success)
+  {
+    return false;
+  }
+  ROS_INFO_STREAM("active map set to " << active_map_name << " in " << (ros::WallTime::now() - start).toSec() << "s");
+
+  // provide the localization map right away if it has been received before
+  sensor_msgs::PointCloud2 cached_map;
+  if (map_prefetcher_->getCachedMap(active_map_name, cached_map))
+  {
+    cached_map.header.stamp = ros::Time::now();
+    client_localization_map_interface_->publishMap(cached_map);
+    ROS_INFO_STREAM("published cached localization map of " << active_map_name << " "
+                                                            << (ros::WallTime::now() - start).toSec()
+                                                            << "s after switching the map");
+  }
   return true;
 }
 
@@ -287,16 +414,48 @@ bool LocatorBridgeNode::clientMapList(bosch_locator_bridge::ClientMapList::Reque
 
 bool LocatorBridgeNode::clientLocalizationStartCb(std_srvs::Empty::Request& req, std_srvs::Empty::Response& res)
 {
+  latency_tracker_.start("localization_mode_switch");
+  latency_tracker_.start("localization_start_to_localized", true);
+  latency_tracker_.cancel("localization_lost_to_localized");
   auto query = loc_client_interface_->getSessionQuery();
-  auto response = loc_client_interface_->call("clientLocalizationStart", query);
-  return true;
+  return callTracked("clientLocalizationStart", query,
+                     { "localization_mode_switch", "localization_start_to_localized" });
 }
 
 bool LocatorBridgeNode::clientLocalizationStopCb(std_srvs::Empty::Request& req, std_srvs::Empty::Response& res)
 {
+  latency_tracker_.start("localization_mode_switch");
+  latency_tracker_.cancel("localization_start_to_localized");
+  latency_tracker_.cancel("localization_lost_to_localized");
   auto query = loc_client_interface_->getSessionQuery();
-  auto response = loc_client_interface_->call("clientLocalizationStop", query);
-  return true;
+  return callTracked("clientLocalizationStop", query, { "localization_mode_switch" });
+}
+
+void LocatorBridgeNode::localizationMapCallback(const sensor_msgs::PointCloud2& map)
+{
+  std::string map_name;
+  {
+    std::lock_guard<std::mutex> lock(map_switch_mutex_);
+    // until the switch is confirmed, the map might still be the one of the previous map and is therefore not cached
+    if (map_switch_confirmed_)
+    {
+      map_name = active_map_name_;
+    }
+    if (map_switch_pending_)
+    {
+      map_switch_pending_ = false;
+      latency_tracker_.stop("map_switch_to_localization_map");
+      ROS_INFO_STREAM("localization map of " << active_map_name_ << " received "
+                                             << (ros::WallTime::now() - map_switch_start_).toSec()
+                                             << "s after switching the map");
+    }
+  }
+  map_prefetcher_->cacheMap(map_name, map);
+
+  if (seed_candidate_scorer_)
+  {
+    seed_candidate_scorer_->setMap(map);
+  }
 }
 
 void LocatorBridgeNode::setSeedCallback(const geometry_msgs::PoseWithCovarianceStamped& msg)
@@ -307,7 +466,6 @@ void LocatorBridgeNode::setSeedCallback(const geometry_msgs::PoseWithCovarianceS
                                                                   << MAP_FRAME_ID);
     return;
   }
-  auto query = loc_client_interface_->getSessionQuery();
   geometry_msgs::Pose2D pose;
   pose.x = msg.pose.pose.position.x;
   pose.y = msg.pose.pose.position.y;
@@ -319,9 +477,53 @@ void LocatorBridgeNode::setSeedCallback(const geometry_msgs::PoseWithCovarianceS
   transform.getBasis().getRPY(r, p, yaw);
   pose.theta = yaw;
 
+  // includes the time needed for scoring seed candidates
+  latency_tracker_.start("seed_to_localized", true);
+
+  if (!seed_candidate_scorer_)
+  {
+    sendSeed(pose);
+    return;
+  }
+
+  const auto candidates =
+      seed_candidate_scorer_->scoreCandidates(pose, static_cast<size_t>(std::max(1, seed_candidates_to_send_)));
+  if (candidates.empty())
+  {
+    ROS_WARN_STREAM("No localization map or scan available for seed candidate scoring. Sending seed unchanged.");
+    sendSeed(pose);
+    return;
+  }
+
+  // send the best candidates in sequence, until the locator reports to be localized
+  const size_t candidates_to_send = candidates.size();
+  for (size_t i = 0; i < candidates_to_send; i++)
+  {
+    const auto& candidate = candidates[i];
+    ROS_INFO_STREAM("sending seed candidate " << i + 1 << "/" << candidates_to_send << ": (" << candidate.pose.x << ", "
+                                              << candidate.pose.y << ", " << candidate.pose.theta
+                                              << "), score: " << candidate.score);
+    sendSeed(candidate.pose);
+    // only poses received after the seed has been set count, older ones may still report a previous localization
+    const auto pose_count = state_monitor_.getState().localization_pose_count;
+    const auto localized = [pose_count](const LocatorStateMonitor::State& state) {
+      return state.localization_pose_count > pose_count &&
+             state.localization_state == bosch_locator_bridge::ClientLocalizationPose::LOC_STATUS_LOCALIZED;
+    };
+    if (i + 1 < candidates_to_send &&
+        state_monitor_.waitFor(localized, seed_candidate_timeout_, []() { return !ros::ok(); }))
+    {
+      break;
+    }
+  }
+}
+
+void LocatorBridgeNode::sendSeed(const geometry_msgs::Pose2D& pose)
+{
+  auto query = loc_client_interface_->getSessionQuery();
   query.set("enforceSeed", true);
   query.set("seedPose", RosMsgsDatagramConverter::makePose2d(pose));
-  auto response = loc_client_interface_->call("clientLocalizationSetSeed", query);
+  callTracked("clientLocalizationSetSeed", query, { "seed_to_localized" });
 }
 
 bool LocatorBridgeNode::clientRecordingStartVisualRecordingCb(bosch_locator_bridge::StartRecording::Request& req,
@@ -330,16 +532,16 @@ bool LocatorBridgeNode::clientRecordingStartVisualRecordingCb(bosch_locator_brid
   auto query = loc_client_interface_->getSessionQuery();
   query.set("recordingName", req.name);  // TODO: rename srv attributes
   last_recording_name_ = req.name;
-  auto response = loc_client_interface_->call("clientRecordingStartVisualRecording", query);
-  return true;
+  latency_tracker_.start("visual_recording_mode_switch");
+  return callTracked("clientRecordingStartVisualRecording", query, { "visual_recording_mode_switch" });
 }
 
 bool LocatorBridgeNode::clientRecordingStopVisualRecordingCb(std_srvs::Empty::Request& req,
                                                              std_srvs::Empty::Response& res)
 {
+  latency_tracker_.start("visual_recording_mode_switch");
   auto query = loc_client_interface_->getSessionQuery();
-  auto response = loc_client_interface_->call("clientRecordingStopVisualRecording", query);
-  return true;
+  return callTracked("clientRecordingStopVisualRecording", query, { "visual_recording_mode_switch" });
 }
 
 bool LocatorBridgeNode::clientMapStartCb(bosch_locator_bridge::ClientMapStart::Request& req,
@@ -352,14 +554,292 @@ bool LocatorBridgeNode::clientMapStartCb(bosch_locator_bridge::ClientMapStart::R
   query.set("recordingName", recording_name);
   query.set("clientMapName", client_map_name);
   last_map_name_ = client_map_name;
-  auto response = loc_client_interface_->call("clientMapStart", query);
-  return true;
+  // a new map replaces any previous map of the same name
+  map_prefetcher_->removeCachedMap(client_map_name);
+  latency_tracker_.start("map_mode_switch");
+  return callTracked("clientMapStart", query, { "map_mode_switch" });
 }
 
 bool LocatorBridgeNode::clientMapStopCb(std_srvs::Empty::Request& req, std_srvs::Empty::Response& res)
 {
+  latency_tracker_.start("map_mode_switch");
   auto query = loc_client_interface_->getSessionQuery();
-  auto response = loc_client_interface_->call("clientMapStop", query);
+  return callTracked("clientMapStop", query, { "map_mode_switch" });
+}
+
+void LocatorBridgeNode::switchModeCb(const bosch_locator_bridge::SwitchModeGoalConstPtr& goal)
+{
+  bosch_locator_bridge::SwitchModeResult result;
+  const auto start = ros::WallTime::now();
+  LocatorStateMonitor::Predicate target_reached;
+  if (!triggerTransition(goal->transition, goal->recording_name, goal->client_map_name, target_reached))
+  {
+    result.success = false;
+    result.message = "transition " + std::to_string(goal->transition) + " unknown or rejected by the locator";
+    result.control_mode = state_monitor_.getState().control_mode;
+    result.elapsed = ros::Duration((ros::WallTime::now() - start).toSec());
+    switch_mode_server_->setAborted(result, result.message);
+    return;
+  }
+
+  // only publish feedback if the modes or the localization state changed
+  uint64_t control_mode_count = 0;
+  int32_t localization_state = 0;
+  const bool success = state_monitor_.waitFor(
+      target_reached, ros::WallDuration(goal->timeout.toSec()),
+      [this]() { return switch_mode_server_->isPreemptRequested() || !ros::ok(); },
+      [&](const LocatorStateMonitor::State& state) {
+        if (state.control_mode_count != control_mode_count || state.localization_state != localization_state)
+        {
+          control_mode_count = state.control_mode_count;
+          localization_state = state.localization_state;
+          bosch_locator_bridge::SwitchModeFeedback feedback;
+          feedback.control_mode = state.control_mode;
+          feedback.localization_state = state.localization_state;
+          switch_mode_server_->publishFeedback(feedback);
+        }
+      });
+
+  result.success = success;
+  result.control_mode = state_monitor_.getState().control_mode;
+  result.elapsed = ros::Duration((ros::WallTime::now() - start).toSec());
+  if (success)
+  {
+    result.message = "target state reached";
+    switch_mode_server_->setSucceeded(result, result.message);
+  }
+  else if (switch_mode_server_->isPreemptRequested())
+  {
+    result.message = "preempted while waiting for target state";
+    switch_mode_server_->setPreempted(result, result.message);
+  }
+  else
+  {
+    result.message = "target state not reached within timeout";
+    switch_mode_server_->setAborted(result, result.message);
+  }
+}
+
+void LocatorBridgeNode::mapWorkflowCb(const bosch_locator_bridge::MapWorkflowGoalConstPtr& goal)
+{
+  using bosch_locator_bridge::ClientControlMode;
+  using bosch_locator_bridge::MapWorkflowFeedback;
+  using bosch_locator_bridge::SwitchModeGoal;
+
+  const auto start = ros::WallTime::now();
+  const ros::WallDuration timeout(goal->timeout.toSec());
+  const auto interrupted = [this]() { return map_workflow_server_->isPreemptRequested() || !ros::ok(); };
+
+  bosch_locator_bridge::MapWorkflowResult result;
+  const std::string recording_name = goal->recording_name.empty() ? last_recording_name_ : goal->recording_name;
+  result.client_map_name = goal->client_map_name.empty() ? "map-from-" + recording_name : goal->client_map_name;
+
+  const auto finish = [&](bool success, const std::string& message) {
+    result.success = success;
+    result.message = message;
+    result.elapsed = ros::Duration((ros::WallTime::now() - start).toSec());
+    if (success)
+    {
+      map_workflow_server_->setSucceeded(result, message);
+    }
+    else if (map_workflow_server_->isPreemptRequested())
+    {
+      map_workflow_server_->setPreempted(result, message);
+    }
+    else
+    {
+      map_workflow_server_->setAborted(result, message);
+    }
+  };
+  const auto publish_stage = [&](uint8_t stage, double progress) {
+    MapWorkflowFeedback feedback;
+    feedback.stage = stage;
+    feedback.progress = progress;
+    map_workflow_server_->publishFeedback(feedback);
+  };
+
+  // stop a running visual recording first
+  if (state_monitor_.getState().control_mode.visual_recording_state == ClientControlMode::CLIENT_CONTROL_STATE_RUN)
+  {
+    publish_stage(MapWorkflowFeedback::STAGE_STOP_VISUAL_RECORDING, 0.0);
+    LocatorStateMonitor::Predicate stopped;
+    if (!triggerTransition(SwitchModeGoal::STOP_VISUAL_RECORDING, "", "", stopped))
+    {
+      finish(false, "stopping the visual recording was rejected by the locator");
+      return;
+    }
+    if (!state_monitor_.waitFor(stopped, timeout, interrupted))
+    {
+      finish(false, "visual recording did not stop");
+      return;
+    }
+  }
+
+  // create the map. It is finished once the map mode has entered and left its RUN state or reports full progress
+  publish_stage(MapWorkflowFeedback::STAGE_CREATE_MAP, 0.0);
+  LocatorStateMonitor::Predicate map_running;
+  if (!triggerTransition(SwitchModeGoal::START_MAP, recording_name, result.client_map_name, map_running))
+  {
+    finish(false, "map creation was rejected by the locator");
+    return;
+  }
+  if (!state_monitor_.waitFor(map_running, timeout, interrupted))
+  {
+    finish(false, "map creation did not start");
+    return;
+  }
+  const auto state_running = state_monitor_.getState();
+  const auto map_finished = [&state_running](const LocatorStateMonitor::State& state) {
+    return state.control_mode.map_state != ClientControlMode::CLIENT_CONTROL_STATE_RUN ||
+           (state.map_visualization_count > state_running.map_visualization_count && state.map_progress >= 1.0);
+  };
+  double progress = 0.0;
+  const bool map_created =
+      state_monitor_.waitFor(map_finished, timeout, interrupted, [&](const LocatorStateMonitor::State& state) {
+        if (state.map_visualization_count > state_running.map_visualization_count && state.map_progress != progress)
+        {
+          progress = state.map_progress;
+          publish_stage(MapWorkflowFeedback::STAGE_CREATE_MAP, progress);
+        }
+      });
+  if (!map_created)
+  {
+    finish(false, "map creation did not finish");
+    return;
+  }
+  if (state_monitor_.getState().control_mode.map_state == ClientControlMode::CLIENT_CONTROL_STATE_RUN)
+  {
+    LocatorStateMonitor::Predicate stopped;
+    if (!triggerTransition(SwitchModeGoal::STOP_MAP, "", "", stopped) ||
+        !state_monitor_.waitFor(stopped, timeout, interrupted))
+    {
+      finish(false, "map creation did not stop");
+      return;
+    }
+  }
+
+  // send the map to the map server and make it the active map
+  publish_stage(MapWorkflowFeedback::STAGE_SEND_MAP, 1.0);
+  bosch_locator_bridge::ClientMapSend::Request send_req;
+  bosch_locator_bridge::ClientMapSend::Response send_res;
+  send_req.name = result.client_map_name;
+  if (!clientMapSendCb(send_req, send_res))
+  {
+    finish(false, "sending map " + result.client_map_name + " failed");
+    return;
+  }
+
+  publish_stage(MapWorkflowFeedback::STAGE_SET_MAP, 1.0);
+  bosch_locator_bridge::ClientMapSet::Request set_req;
+  bosch_locator_bridge::ClientMapSet::Response set_res;
+  set_req.name = result.client_map_name;
+  if (!clientMapSetCb(set_req, set_res))
+  {
+    finish(false, "setting map " + result.client_map_name + " failed");
+    return;
+  }
+
+  finish(true, "map " + result.client_map_name + " created, sent and set");
+}
+
+bool LocatorBridgeNode::triggerTransition(uint8_t transition, const std::string& recording_name,
+                                          const std::string& client_map_name,
+                                          LocatorStateMonitor::Predicate& target_reached)
+{
+  using bosch_locator_bridge::ClientControlMode;
+  using bosch_locator_bridge::SwitchModeGoal;
+  using State = LocatorStateMonitor::State;
+
+  // only control modes received after the request count, the cached one may still report the previous state
+  const auto control_mode_count = state_monitor_.getState().control_mode_count;
+  std_srvs::Empty::Request req;
+  std_srvs::Empty::Response res;
+  switch (transition)
+  {
+    case SwitchModeGoal::START_VISUAL_RECORDING:
+    {
+      bosch_locator_bridge::StartRecording::Request start_req;
+      bosch_locator_bridge::StartRecording::Response start_res;
+      start_req.name = recording_name;
+      target_reached = [control_mode_count](const State& state) {
+        return state.control_mode_count > control_mode_count &&
+               state.control_mode.visual_recording_state == ClientControlMode::CLIENT_CONTROL_STATE_RUN;
+      };
+      return clientRecordingStartVisualRecordingCb(start_req, start_res);
+    }
+    case SwitchModeGoal::STOP_VISUAL_RECORDING:
+      target_reached = [control_mode_count](const State& state) {
+        return state.control_mode_count > control_mode_count &&
+               state.control_mode.visual_recording_state != ClientControlMode::CLIENT_CONTROL_STATE_RUN;
+      };
+      return clientRecordingStopVisualRecordingCb(req, res);
+    case SwitchModeGoal::START_MAP:
+    {
+      bosch_locator_bridge::ClientMapStart::Request start_req;
+      bosch_locator_bridge::ClientMapStart::Response start_res;
+      start_req.recording_name = recording_name;
+      start_req.client_map_name = client_map_name;
+      target_reached = [control_mode_count](const State& state) {
+        return state.control_mode_count > control_mode_count &&
+               state.control_mode.map_state == ClientControlMode::CLIENT_CONTROL_STATE_RUN;
+      };
+      return clientMapStartCb(start_req, start_res);
+    }
+    case SwitchModeGoal::STOP_MAP:
+      target_reached = [control_mode_count](const State& state) {
+        return state.control_mode_count > control_mode_count &&
+               state.control_mode.map_state != ClientControlMode::CLIENT_CONTROL_STATE_RUN;
+      };
+      return clientMapStopCb(req, res);
+    case SwitchModeGoal::START_LOCALIZATION:
+    {
+      if (!clientLocalizationStartCb(req, res))
+      {
+        return false;
+      }
+      // only poses received after the start count, older ones may still report a previous localization
+      const auto pose_count = state_monitor_.getState().localization_pose_count;
+      target_reached = [pose_count](const State& state) {
+        return state.control_mode.localization_state == ClientControlMode::CLIENT_CONTROL_STATE_RUN &&
+               state.localization_pose_count > pose_count &&
+               state.localization_state == bosch_locator_bridge::ClientLocalizationPose::LOC_STATUS_LOCALIZED;
+      };
+      return true;
+    }
+    case SwitchModeGoal::STOP_LOCALIZATION:
+      target_reached = [control_mode_count](const State& state) {
+        return state.control_mode_count > control_mode_count &&
+               state.control_mode.localization_state != ClientControlMode::CLIENT_CONTROL_STATE_RUN;
+      };
+      return clientLocalizationStopCb(req, res);
+    default:
+      return false;
+  }
+}
+
+bool LocatorBridgeNode::callTracked(const std::string& method, const Poco::JSON::Object& query,
+                                    std::initializer_list<std::string> intervals)
+{
+  // call() returns an empty object if the RPC failed
+  return callTracked([&]() { return loc_client_interface_->call(method, query).has("responseCode"); }, intervals);
+}
+
+bool LocatorBridgeNode::callTracked(const std::function<bool()>& rpc, std::initializer_list<std::string> intervals)
+{
+  if (!rpc())
+  {
+    for (const auto& interval : intervals)
+    {
+      latency_tracker_.cancel(interval);
+    }
+    return false;
+  }
+  // poses sent before the request took effect may still report a previous localization
+  const auto pose_count = state_monitor_.getState().localization_pose_count;
+  for (const auto& interval : intervals)
+  {
+    latency_tracker_.ignoreUntil(interval, pose_count);
+  }
   return true;
 }
 
@@ -525,34 +1005,117 @@ void LocatorBridgeNode::checkLaserScan(const sensor_msgs::LaserScan& msg,
 
 void LocatorBridgeNode::setupBinaryReceiverInterfaces(const std::string& host)
 {
+  // measures the time until the first datagram is received on an interface
+  const auto first_datagram = [this](const std::string& interface) {
+    return [this, interface]() { latency_tracker_.milestone(interface + "_first_datagram"); };
+  };
+
   // Create binary interface for client control mode
   client_control_mode_interface_.reset(new ClientControlModeInterface(Poco::Net::IPAddress(host), nh_));
+  client_control_mode_interface_->setFirstDatagramCallback(first_datagram("client_control_mode"));
+  client_control_mode_interface_->setControlModeCallback(
+      [this](const bosch_locator_bridge::ClientControlMode& control_mode) {
+        state_monitor_.updateControlMode(control_mode);
+        trackControlModeLatency(control_mode);
+      });
   client_control_mode_interface_thread_.start(*client_control_mode_interface_);
   // Create binary interface for client map map
   client_map_map_interface_.reset(new ClientMapMapInterface(Poco::Net::IPAddress(host), nh_));
+  client_map_map_interface_->setFirstDatagramCallback(first_datagram("client_map_map"));
   client_map_map_interface_thread_.start(*client_map_map_interface_);
   // Create binary interface for client map visualization
   client_map_visualization_interface_.reset(new ClientMapVisualizationInterface(Poco::Net::IPAddress(host), nh_));
+  client_map_visualization_interface_->setFirstDatagramCallback(first_datagram("client_map_visualization"));
+  client_map_visualization_interface_->setVisualizationCallback(
+      [this](const bosch_locator_bridge::ClientMapVisualization& visualization) {
+        state_monitor_.updateMapVisualization(visualization);
+      });
   client_map_visualization_interface_thread_.start(*client_map_visualization_interface_);
   // Create binary interface for client recording map
   client_recording_map_interface_.reset(new ClientRecordingMapInterface(Poco::Net::IPAddress(host), nh_));
+  client_recording_map_interface_->setFirstDatagramCallback(first_datagram("client_recording_map"));
   client_recording_map_interface_thread_.start(*client_recording_map_interface_);
   // Create binary interface for client recording visualization
   client_recording_visualization_interface_.reset(
       new ClientRecordingVisualizationInterface(Poco::Net::IPAddress(host), nh_));
+  client_recording_visualization_interface_->setFirstDatagramCallback(
+      first_datagram("client_recording_visualization"));
   client_recording_visualization_interface_thread_.start(*client_recording_visualization_interface_);
   // Create binary interface for client localization map
   client_localization_map_interface_.reset(new ClientLocalizationMapInterface(Poco::Net::IPAddress(host), nh_));
+  client_localization_map_interface_->setFirstDatagramCallback(first_datagram("client_localization_map"));
+  client_localization_map_interface_->setMapCallback(
+      [this](const sensor_msgs::PointCloud2& map) { localizationMapCallback(map); });
   client_localization_map_interface_thread_.start(*client_localization_map_interface_);
   // Create binary interface for ClientLocalizationVisualizationInterface
   client_localization_visualization_interface_.reset(
       new ClientLocalizationVisualizationInterface(Poco::Net::IPAddress(host), nh_));
+  client_localization_visualization_interface_->setFirstDatagramCallback(
+      first_datagram("client_localization_visualization"));
+  if (seed_candidate_scorer_)
+  {
+    client_localization_visualization_interface_->setVisualizationCallback(
+        [this](const bosch_locator_bridge::ClientLocalizationVisualization&, const geometry_msgs::PoseStamped& pose,
+               const sensor_msgs::PointCloud2& scan) { seed_candidate_scorer_->setScan(pose.pose, scan); });
+  }
   client_localization_visualization_interface_thread_.start(*client_localization_visualization_interface_);
   // Create binary interface for ClientLocalizationPoseInterface
   client_localization_pose_interface_.reset(new ClientLocalizationPoseInterface(Poco::Net::IPAddress(host), nh_));
+  client_localization_pose_interface_->setFirstDatagramCallback(first_datagram("client_localization_pose"));
+  client_localization_pose_interface_->setPoseCallback(
+      [this](const bosch_locator_bridge::ClientLocalizationPose& pose) {
+        state_monitor_.updateLocalizationPose(pose);
+        const bool localized = pose.state == bosch_locator_bridge::ClientLocalizationPose::LOC_STATUS_LOCALIZED;
+        if (localized)
+        {
+          // only this thread updates the pose count, so it is the one of this pose
+          const auto pose_count = state_monitor_.getState().localization_pose_count;
+          latency_tracker_.milestone("localized");
+          latency_tracker_.stop("seed_to_localized", pose_count);
+          latency_tracker_.stop("map_switch_to_localized", pose_count);
+          latency_tracker_.stop("localization_start_to_localized", pose_count);
+          latency_tracker_.stop("localization_lost_to_localized");
+        }
+        else if (localized_ && state_monitor_.getState().control_mode.localization_state ==
+                                   bosch_locator_bridge::ClientControlMode::CLIENT_CONTROL_STATE_RUN)
+        {
+          // lost while the localization keeps running, i.e. not because it is being stopped
+          latency_tracker_.start("localization_lost_to_localized");
+        }
+        localized_ = localized;
+      });
   client_localization_pose_interface_thread_.start(*client_localization_pose_interface_);
   // Create binary interface for ClientGlobalAlignVisualizationInterface
   client_global_align_visualization_interface_.reset(
       new ClientGlobalAlignVisualizationInterface(Poco::Net::IPAddress(host), nh_));
+  client_global_align_visualization_interface_->setFirstDatagramCallback(
+      first_datagram("client_global_align_visualization"));
   client_global_align_visualization_interface_thread_.start(*client_global_align_visualization_interface_);
 }
+
+void LocatorBridgeNode::trackControlModeLatency(const bosch_locator_bridge::ClientControlMode& control_mode)
+{
+  using bosch_locator_bridge::ClientControlMode;
+  if (control_mode.localization_state == ClientControlMode::CLIENT_CONTROL_STATE_RUN)
+  {
+    latency_tracker_.milestone("localization_running");
+  }
+
+  if (control_mode_received_)
+  {
+    if (control_mode.visual_recording_state != last_control_mode_.visual_recording_state)
+    {
+      latency_tracker_.stop("visual_recording_mode_switch");
+    }
+    if (control_mode.map_state != last_control_mode_.map_state)
+    {
+      latency_tracker_.stop("map_mode_switch");
+    }
+    if (control_mode.localization_state != last_control_mode_.localization_state)
+    {
+      latency_tracker_.stop("localization_mode_switch");
+    }
+  }
+  last_control_mode_ = control_mode;
+  control_mode_received_ = true;
+}
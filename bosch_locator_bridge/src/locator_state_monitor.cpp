@@ -0,0 +1,116 @@
+// Copyright (c) 2021 - for information on the respective copyright owner
+// see the NOTICE file and/or the repository https://github.com/boschglobal/locator_ros_bridge.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "locator_state_monitor.hpp"
+
+#include <chrono>
+
+void LocatorStateMonitor::updateControlMode(const bosch_locator_bridge::ClientControlMode& control_mode)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_.control_mode = control_mode;
+    state_.control_mode_count++;
+    version_++;
+  }
+  cv_.notify_all();
+}
+
+void LocatorStateMonitor::updateLocalizationPose(const bosch_locator_bridge::ClientLocalizationPose& pose)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_.localization_state = pose.state;
+    state_.localization_pose_count++;
+    version_++;
+  }
+  cv_.notify_all();
+}
+
+void LocatorStateMonitor::updateMapVisualization(const bosch_locator_bridge::ClientMapVisualization& visualization)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_.map_progress = visualization.progress;
+    state_.map_visualization_count++;
+    version_++;
+  }
+  cv_.notify_all();
+}
+
+LocatorStateMonitor::State LocatorStateMonitor::getState() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return state_;
+}
+
+bool LocatorStateMonitor::waitFor(const Predicate& done, const ros::WallDuration& timeout,
+                                  const std::function<bool()>& interrupted, const UpdateCallback& on_update)
+{
+  const bool has_timeout = !timeout.isZero();
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(timeout.toNSec());
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t seen_version = version_;
+  // differs from interrupt_count_ to check the interrupted condition once before waiting the first time
+  uint64_t seen_interrupt_count = interrupt_count_ - 1;
+  while (!done(state_))
+  {
+    // the callbacks are invoked unlocked, since they may take other locks or trigger further updates
+    if (seen_interrupt_count != interrupt_count_)
+    {
+      seen_interrupt_count = interrupt_count_;
+      lock.unlock();
+      const bool abort = interrupted && interrupted();
+      lock.lock();
+      if (abort)
+      {
+        return false;
+      }
+      continue;
+    }
+    if (on_update && seen_version != version_)
+    {
+      seen_version = version_;
+      const State state = state_;
+      lock.unlock();
+      on_update(state);
+      lock.lock();
+      continue;
+    }
+
+    if (has_timeout)
+    {
+      if (cv_.wait_until(lock, deadline) == std::cv_status::timeout)
+      {
+        return done(state_);
+      }
+    }
+    else
+    {
+      cv_.wait(lock);
+    }
+  }
+  return true;
+}
+
+void LocatorStateMonitor::interrupt()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    interrupt_count_++;
+  }
+  cv_.notify_all();
+}
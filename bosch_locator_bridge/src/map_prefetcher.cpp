@@ -0,0 +1,144 @@
+// Copyright (c) 2021 - for information on the respective copyright owner
+// see the NOTICE file and/or the repository https://github.com/boschglobal/locator_ros_bridge.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "map_prefetcher.hpp"
+
+#include "locator_rpc_interface.hpp"
+
+#include <ros/ros.h>
+
+MapPrefetcher::MapPrefetcher(std::unique_ptr<LocatorRPCInterface> rpc_interface, size_t cache_size)
+  : rpc_interface_(std::move(rpc_interface)), cache_size_(cache_size)
+{
+}
+
+MapPrefetcher::~MapPrefetcher()
+{
+  if (prefetch_thread_.joinable())
+  {
+    prefetch_thread_.join();
+  }
+}
+
+void MapPrefetcher::refresh()
+{
+  rpc_interface_->refresh();
+}
+
+bool MapPrefetcher::prefetch(const std::string& client_map_name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!prefetching_map_name_.empty())
+  {
+    ROS_WARN_STREAM("cannot prefetch map " << client_map_name << ", still sending map " << prefetching_map_name_);
+    return false;
+  }
+  // the previous prefetch has finished already, so joining does not block
+  if (prefetch_thread_.joinable())
+  {
+    prefetch_thread_.join();
+  }
+  prefetching_map_name_ = client_map_name;
+  failed_map_names_.erase(client_map_name);
+  // the map server might get a different map of the same name
+  removeCachedMapLocked(client_map_name);
+  prefetch_thread_ = std::thread(&MapPrefetcher::sendMap, this, client_map_name);
+  return true;
+}
+
+bool MapPrefetcher::waitForPrefetch(const std::string& client_map_name)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  prefetch_cv_.wait(lock, [&]() { return prefetching_map_name_ != client_map_name; });
+  return failed_map_names_.count(client_map_name) == 0;
+}
+
+void MapPrefetcher::markMapSent(const std::string& client_map_name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  failed_map_names_.erase(client_map_name);
+}
+
+void MapPrefetcher::sendMap(const std::string& client_map_name)
+{
+  const auto start = ros::WallTime::now();
+  auto query = rpc_interface_->getSessionQuery();
+  query.set("clientMapName", client_map_name);
+  const auto response = rpc_interface_->call("clientMapSend", query);
+  // call() returns an empty object if the RPC failed
+  const bool success = response.has("responseCode");
+  if (success)
+  {
+    ROS_INFO_STREAM("prefetched map " << client_map_name << " in " << (ros::WallTime::now() - start).toSec() << "s");
+  }
+  else
+  {
+    ROS_ERROR_STREAM("prefetching map " << client_map_name << " failed");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!success)
+    {
+      failed_map_names_.insert(client_map_name);
+    }
+    prefetching_map_name_.clear();
+  }
+  prefetch_cv_.notify_all();
+}
+
+void MapPrefetcher::cacheMap(const std::string& client_map_name, const sensor_msgs::PointCloud2& map)
+{
+  if (cache_size_ == 0 || client_map_name.empty())
+  {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  removeCachedMapLocked(client_map_name);
+  map_cache_.emplace_front(client_map_name, map);
+  while (map_cache_.size() > cache_size_)
+  {
+    map_cache_.pop_back();
+  }
+}
+
+bool MapPrefetcher::getCachedMap(const std::string& client_map_name, sensor_msgs::PointCloud2& map)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto iter = map_cache_.begin(); iter != map_cache_.end(); ++iter)
+  {
+    if (iter->first == client_map_name)
+    {
+      map = iter->second;
+      // mark as most recently used
+      map_cache_.splice(map_cache_.begin(), map_cache_, iter);
+      return true;
+    }
+  }
+  return false;
+}
+
+void MapPrefetcher::removeCachedMap(const std::string& client_map_name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  removeCachedMapLocked(client_map_name);
+}
+
+void MapPrefetcher::removeCachedMapLocked(const std::string& client_map_name)
+{
+  map_cache_.remove_if([&](const std::pair<std::string, sensor_msgs::PointCloud2>& entry) {
+    return entry.first == client_map_name;
+  });
+}
@@ -26,8 +26,9 @@
 
 #include <Poco/NObserver.h>
 
-ReceivingInterface::ReceivingInterface(const Poco::Net::IPAddress& hostadress, Poco::UInt16 port, ros::NodeHandle& nh)
-  : nh_(nh), ccm_socket_(Poco::Net::SocketAddress(hostadress, port))
+ReceivingInterface::ReceivingInterface(const Poco::Net::IPAddress& hostadress, Poco::UInt16 port, ros::NodeHandle& nh,
+                                       size_t max_datagram_size)
+  : nh_(nh), max_datagram_size_(max_datagram_size), ccm_socket_(Poco::Net::SocketAddress(hostadress, port))
 {
   reactor_.addEventHandler(ccm_socket_, Poco::NObserver<ReceivingInterface, Poco::Net::ReadableNotification>(
                                             *this, &ReceivingInterface::onReadEvent));
@@ -46,19 +47,35 @@ void ReceivingInterface::onReadEvent(const Poco::AutoPtr<Poco::Net::ReadableNoti
     // Create buffer with size of available data
     const int bytes_available = ccm_socket_.available();
     std::vector<char> msg(bytes_available);
-    int received_bytes = ccm_socket_.receiveBytes(&(msg[0]), bytes_available);
+    int received_bytes = ccm_socket_.receiveBytes(msg.data(), bytes_available);
     if (received_bytes == 0)
     {
       std::cout << "received msg of length 0... Connection closed? \n";
     }
     else
     {
-      datagram_buffer_.insert(datagram_buffer_.end(), msg.begin(), msg.end());
+      datagram_buffer_.insert(datagram_buffer_.end(), msg.begin(), msg.begin() + received_bytes);
+      // a complete datagram is never much larger than max_datagram_size_, more data means the stream is corrupt
+      if (datagram_buffer_.size() > 2 * max_datagram_size_)
+      {
+        ROS_ERROR_STREAM("Discarding " << datagram_buffer_.size() << " bytes of unparseable data in "
+                                       << "ReceivingInterface!");
+        datagram_buffer_.clear();
+        return;
+      }
 
       size_t bytes_to_delete = 0;
       // Try to parse messages from the buffer until tryToParseData fails to parse a full message
       do {
         bytes_to_delete = tryToParseData(datagram_buffer_);
+        if (bytes_to_delete > 0 && !first_datagram_parsed_)
+        {
+          first_datagram_parsed_ = true;
+          if (first_datagram_callback_)
+          {
+            first_datagram_callback_();
+          }
+        }
         datagram_buffer_.erase(
           datagram_buffer_.begin(),
           datagram_buffer_.begin() + bytes_to_delete);
@@ -70,6 +87,17 @@ void ReceivingInterface::onReadEvent(const Poco::AutoPtr<Poco::Net::ReadableNoti
     // catching this exception is actually no error: the datagram is just not yet completely transmitted could not be
     // parsed because of that. Will automatically retry after more data is available.
   }
+  catch (const CorruptDatagramError& error)
+  {
+    // the stream cannot be resynchronized after a corrupt datagram, so drop everything received so far
+    ROS_ERROR_STREAM("Discarding corrupt datagram in ReceivingInterface: " << error.what());
+    datagram_buffer_.clear();
+  }
+  catch (const std::exception& error)
+  {
+    // thrown while handling a correctly decoded datagram, e.g. by a callback
+    ROS_ERROR_STREAM("Caught exception in ReceivingInterface: " << error.what());
+  }
   catch (...)
   {
     ROS_ERROR_STREAM("Caught exception in ReceivingInterface!");
@@ -81,8 +109,14 @@ void ReceivingInterface::run()
   reactor_.run();
 }
 
+void ReceivingInterface::setFirstDatagramCallback(const FirstDatagramCallback& callback)
+{
+  first_datagram_callback_ = callback;
+}
+
 ClientControlModeInterface::ClientControlModeInterface(const Poco::Net::IPAddress& hostadress, ros::NodeHandle& nh)
-  : ReceivingInterface(hostadress, BINARY_CLIENT_CONTROL_MODE_PORT, nh)
+  : ReceivingInterface(hostadress, BINARY_CLIENT_CONTROL_MODE_PORT, nh,
+                       RosMsgsDatagramConverter::MAX_STATE_DATAGRAM_SIZE)
 {
   // Setup publisher
   publishers_.push_back(nh.advertise<bosch_locator_bridge::ClientControlMode>("client_control_mode", 5, true));
@@ -98,12 +132,21 @@ size_t ClientControlModeInterface::tryToParseData(const std::vector<char>& datag
   {
     // publish client control mode
     publishers_[0].publish(client_control_mode);
+    if (control_mode_callback_)
+    {
+      control_mode_callback_(client_control_mode);
+    }
   }
   return parsed_bytes;
 }
 
+void ClientControlModeInterface::setControlModeCallback(const ControlModeCallback& callback)
+{
+  control_mode_callback_ = callback;
+}
+
 ClientMapMapInterface::ClientMapMapInterface(const Poco::Net::IPAddress& hostadress, ros::NodeHandle& nh)
-  : ReceivingInterface(hostadress, BINARY_CLIENT_MAP_MAP_PORT, nh)
+  : ReceivingInterface(hostadress, BINARY_CLIENT_MAP_MAP_PORT, nh, RosMsgsDatagramConverter::MAX_DATAGRAM_SIZE)
 {
   // Setup publisher
   publishers_.push_back(nh.advertise<sensor_msgs::PointCloud2>("client_map_map", 5));
@@ -113,7 +156,8 @@ size_t ClientMapMapInterface::tryToParseData(const std::vector<char>& datagram)
 {
   // convert datagram to ros message
   sensor_msgs::PointCloud2 map;
-  const auto parsed_bytes = RosMsgsDatagramConverter::convertMapDatagram2Message(datagram, ros::Time::now(), map);
+  const auto parsed_bytes =
+      RosMsgsDatagramConverter::convertMapDatagram2Message(datagram, ros::Time::now(), map, max_datagram_size_);
   if (parsed_bytes > 0)
   {
     // publish
@@ -124,7 +168,8 @@ size_t ClientMapMapInterface::tryToParseData(const std::vector<char>& datagram)
 
 ClientMapVisualizationInterface::ClientMapVisualizationInterface(const Poco::Net::IPAddress& hostadress,
                                                                  ros::NodeHandle& nh)
-  : ReceivingInterface(hostadress, BINARY_CLIENT_MAP_VISUALIZATION_PORT, nh)
+  : ReceivingInterface(hostadress, BINARY_CLIENT_MAP_VISUALIZATION_PORT, nh,
+                       RosMsgsDatagramConverter::MAX_VISUALIZATION_DATAGRAM_SIZE)
 {
   // Setup publisher
   publishers_.push_back(nh.advertise<bosch_locator_bridge::ClientMapVisualization>("client_map_visualization", 5));
@@ -142,7 +187,7 @@ size_t ClientMapVisualizationInterface::tryToParseData(const std::vector<char>&
   geometry_msgs::PoseArray path_poses;
 
   const auto bytes_parsed = RosMsgsDatagramConverter::convertClientMapVisualizationDatagram2Message(
-      datagram, client_map_visualization, pose, scan, path_poses);
+      datagram, client_map_visualization, pose, scan, path_poses, max_datagram_size_);
 
   if (bytes_parsed > 0)
   {
@@ -151,12 +196,21 @@ size_t ClientMapVisualizationInterface::tryToParseData(const std::vector<char>&
     publishers_[1].publish(pose);
     publishers_[2].publish(scan);
     publishers_[3].publish(path_poses);
+    if (visualization_callback_)
+    {
+      visualization_callback_(client_map_visualization);
+    }
   }
   return bytes_parsed;
 }
 
+void ClientMapVisualizationInterface::setVisualizationCallback(const VisualizationCallback& callback)
+{
+  visualization_callback_ = callback;
+}
+
 ClientRecordingMapInterface::ClientRecordingMapInterface(const Poco::Net::IPAddress& hostadress, ros::NodeHandle& nh)
-  : ReceivingInterface(hostadress, BINARY_CLIENT_RECORDING_MAP_PORT, nh)
+  : ReceivingInterface(hostadress, BINARY_CLIENT_RECORDING_MAP_PORT, nh, RosMsgsDatagramConverter::MAX_DATAGRAM_SIZE)
 {
   // Setup publisher
   publishers_.push_back(nh.advertise<sensor_msgs::PointCloud2>("client_recording_map", 5));
@@ -166,7 +220,8 @@ size_t ClientRecordingMapInterface::tryToParseData(const std::vector<char>& data
 {
   // convert datagram to ros message
   sensor_msgs::PointCloud2 map;
-  const auto parsed_bytes = RosMsgsDatagramConverter::convertMapDatagram2Message(datagram, ros::Time::now(), map);
+  const auto parsed_bytes =
+      RosMsgsDatagramConverter::convertMapDatagram2Message(datagram, ros::Time::now(), map, max_datagram_size_);
   if (parsed_bytes > 0)
   {
     // publish
@@ -177,7 +232,8 @@ size_t ClientRecordingMapInterface::tryToParseData(const std::vector<char>& data
 
 ClientRecordingVisualizationInterface::ClientRecordingVisualizationInterface(const Poco::Net::IPAddress& hostadress,
                                                                              ros::NodeHandle& nh)
-  : ReceivingInterface(hostadress, BINARY_CLIENT_RECORDING_VISUALIZATION_PORT, nh)
+  : ReceivingInterface(hostadress, BINARY_CLIENT_RECORDING_VISUALIZATION_PORT, nh,
+                       RosMsgsDatagramConverter::MAX_VISUALIZATION_DATAGRAM_SIZE)
 {
   // Setup publisher
   publishers_.push_back(
@@ -196,7 +252,7 @@ size_t ClientRecordingVisualizationInterface::tryToParseData(const std::vector<c
   geometry_msgs::PoseArray path_poses;
 
   const auto parsed_bytes = RosMsgsDatagramConverter::convertClientRecordingVisualizationDatagram2Message(
-      datagram, client_recording_visualization, pose, scan, path_poses);
+      datagram, client_recording_visualization, pose, scan, path_poses, max_datagram_size_);
 
   if (parsed_bytes > 0)
   {
@@ -211,7 +267,8 @@ size_t ClientRecordingVisualizationInterface::tryToParseData(const std::vector<c
 
 ClientLocalizationMapInterface::ClientLocalizationMapInterface(const Poco::Net::IPAddress& hostadress,
                                                                ros::NodeHandle& nh)
-  : ReceivingInterface(hostadress, BINARY_CLIENT_LOCALIZATION_MAP_PORT, nh)
+  : ReceivingInterface(hostadress, BINARY_CLIENT_LOCALIZATION_MAP_PORT, nh,
+                       RosMsgsDatagramConverter::MAX_DATAGRAM_SIZE)
 {
   // Setup publisher
   // enable latching, since this is usually only published once
@@ -222,18 +279,34 @@ size_t ClientLocalizationMapInterface::tryToParseData(const std::vector<char>& d
 {
   // convert datagram to ros message
   sensor_msgs::PointCloud2 map;
-  const auto bytes_parsed = RosMsgsDatagramConverter::convertMapDatagram2Message(datagram, ros::Time::now(), map);
+  const auto bytes_parsed =
+      RosMsgsDatagramConverter::convertMapDatagram2Message(datagram, ros::Time::now(), map, max_datagram_size_);
   if (bytes_parsed > 0)
   {
     // publish
     publishers_[0].publish(map);
+    if (map_callback_)
+    {
+      map_callback_(map);
+    }
   }
   return bytes_parsed;
 }
 
+void ClientLocalizationMapInterface::setMapCallback(const MapCallback& callback)
+{
+  map_callback_ = callback;
+}
+
+void ClientLocalizationMapInterface::publishMap(const sensor_msgs::PointCloud2& map)
+{
+  publishers_[0].publish(map);
+}
+
 ClientLocalizationVisualizationInterface::ClientLocalizationVisualizationInterface(
     const Poco::Net::IPAddress& hostadress, ros::NodeHandle& nh)
-  : ReceivingInterface(hostadress, BINARY_CLIENT_LOCALIZATION_VISUALIZATION_PORT, nh)
+  : ReceivingInterface(hostadress, BINARY_CLIENT_LOCALIZATION_VISUALIZATION_PORT, nh,
+                       RosMsgsDatagramConverter::MAX_VISUALIZATION_DATAGRAM_SIZE)
 {
   // Setup publisher
   publishers_.push_back(
@@ -250,7 +323,7 @@ size_t ClientLocalizationVisualizationInterface::tryToParseData(const std::vecto
   sensor_msgs::PointCloud2 scan;
 
   const auto bytes_parsed = RosMsgsDatagramConverter::convertClientLocalizationVisualizationDatagram2Message(
-      datagram, client_localization_visualization, pose, scan);
+      datagram, client_localization_visualization, pose, scan, max_datagram_size_);
 
   if (bytes_parsed > 0)
   {
@@ -258,13 +331,23 @@ size_t ClientLocalizationVisualizationInterface::tryToParseData(const std::vecto
     publishers_[0].publish(client_localization_visualization);
     publishers_[1].publish(pose);
     publishers_[2].publish(scan);
+    if (visualization_callback_)
+    {
+      visualization_callback_(client_localization_visualization, pose, scan);
+    }
   }
   return bytes_parsed;
 }
 
+void ClientLocalizationVisualizationInterface::setVisualizationCallback(const VisualizationCallback& callback)
+{
+  visualization_callback_ = callback;
+}
+
 ClientLocalizationPoseInterface::ClientLocalizationPoseInterface(const Poco::Net::IPAddress& hostadress,
                                                                  ros::NodeHandle& nh)
-  : ReceivingInterface(hostadress, BINARY_CLIENT_LOCALIZATION_POSE_PORT, nh)
+  : ReceivingInterface(hostadress, BINARY_CLIENT_LOCALIZATION_POSE_PORT, nh,
+                       RosMsgsDatagramConverter::MAX_STATE_DATAGRAM_SIZE)
 {
   // Setup publisher
   publishers_.push_back(nh.advertise<bosch_locator_bridge::ClientLocalizationPose>("client_localization_pose", 5));
@@ -301,13 +384,23 @@ size_t ClientLocalizationPoseInterface::tryToParseData(const std::vector<char>&
     publishers_[0].publish(client_localization_pose);
     publishers_[1].publish(poseWithCov);
     publishers_[2].publish(lidar_odo_pose);
+    if (pose_callback_)
+    {
+      pose_callback_(client_localization_pose);
+    }
   }
   return bytes_parsed;
 }
 
+void ClientLocalizationPoseInterface::setPoseCallback(const PoseCallback& callback)
+{
+  pose_callback_ = callback;
+}
+
 ClientGlobalAlignVisualizationInterface::ClientGlobalAlignVisualizationInterface(const Poco::Net::IPAddress& hostadress,
                                                                                  ros::NodeHandle& nh)
-  : ReceivingInterface(hostadress, BINARY_CLIENT_GLOBAL_ALIGN_VISUALIZATION_PORT, nh)
+  : ReceivingInterface(hostadress, BINARY_CLIENT_GLOBAL_ALIGN_VISUALIZATION_PORT, nh,
+                       RosMsgsDatagramConverter::MAX_VISUALIZATION_DATAGRAM_SIZE)
 {
   // Setup publisher
   publishers_.push_back(
@@ -324,7 +417,7 @@ size_t ClientGlobalAlignVisualizationInterface::tryToParseData(const std::vector
   geometry_msgs::PoseArray landmark_poses;
 
   const auto bytes_parsed = RosMsgsDatagramConverter::convertClientGlobalAlignVisualizationDatagram2Message(
-      datagram, client_global_align_visualization, poses, landmark_poses);
+      datagram, client_global_align_visualization, poses, landmark_poses, max_datagram_size_);
 
   if (bytes_parsed > 0)
   {
@@ -25,7 +25,10 @@
 #include <Poco/BinaryWriter.h>
 #include <Poco/MemoryStream.h>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <stdexcept>
 
 size_t
 RosMsgsDatagramConverter::convertClientControlMode2Message(const std::vector<char>& datagram, const ros::Time& stamp,
@@ -49,23 +52,27 @@ RosMsgsDatagramConverter::convertClientControlMode2Message(const std::vector<cha
 }
 
 size_t RosMsgsDatagramConverter::convertMapDatagram2Message(const std::vector<char>& datagram, const ros::Time& stamp,
-                                                            sensor_msgs::PointCloud2& out_pointcloud)
+                                                            sensor_msgs::PointCloud2& out_pointcloud,
+                                                            size_t max_datagram_size)
 {
-  Poco::MemoryInputStream inStream(&datagram[0], datagram.size());
+  Poco::MemoryInputStream inStream(datagram.data(), datagram.size());
   auto binary_reader = Poco::BinaryReader(inStream, Poco::BinaryReader::LITTLE_ENDIAN_BYTE_ORDER);
   binary_reader.setExceptions(std::ifstream::failbit | std::ifstream::badbit | std::ifstream::eofbit);
-  return convertMapDatagram2Message(binary_reader, stamp, out_pointcloud);
+  return convertMapDatagram2Message(binary_reader, stamp, out_pointcloud, max_datagram_size);
 }
 
 size_t RosMsgsDatagramConverter::convertMapDatagram2Message(Poco::BinaryReader& binary_reader, const ros::Time& stamp,
-                                                            sensor_msgs::PointCloud2& out_pointcloud)
+                                                            sensor_msgs::PointCloud2& out_pointcloud,
+                                                            size_t max_datagram_size)
 {
   // Convert datagram to point cloud
   pcl::PointCloud<pcl::PointXYZ> point_cloud;
   uint32_t map_length;
   binary_reader >> map_length;
   size_t bytes_parsed = 4;
+  checkAvailable(binary_reader, map_length, 2 * 4, max_datagram_size);
 
+  point_cloud.reserve(map_length);
   for (unsigned int i = 0; i < map_length; i++)
   {
     pcl::PointXYZ pt(0.f, 0.f, 0.f);
@@ -75,7 +82,7 @@ size_t RosMsgsDatagramConverter::convertMapDatagram2Message(Poco::BinaryReader&
   }
 
   // Discard the extension part of the datagram
-  bytes_parsed += discardExtension(binary_reader);
+  bytes_parsed += discardExtension(binary_reader, max_datagram_size);
 
   // Create message
   pcl::toROSMsg(point_cloud, out_pointcloud);
@@ -86,13 +93,16 @@ size_t RosMsgsDatagramConverter::convertMapDatagram2Message(Poco::BinaryReader&
 }
 
 size_t RosMsgsDatagramConverter::convertMapDatagram2PointCloud(Poco::BinaryReader& binary_reader,
-                                                               pcl::PointCloud<pcl::PointXYZRGB>& out_pointcloud)
+                                                               pcl::PointCloud<pcl::PointXYZRGB>& out_pointcloud,
+                                                               size_t max_datagram_size)
 {
   // Convert datagram to point cloud
   uint32_t map_length;
   binary_reader >> map_length;
   size_t bytes_parsed = 4;
+  checkAvailable(binary_reader, map_length, 2 * 4, max_datagram_size);
 
+  out_pointcloud.reserve(map_length);
   for (unsigned int i = 0; i < map_length; i++)
   {
     pcl::PointXYZRGB pt(0.f, 0.f, 0.f);
@@ -107,15 +117,15 @@ size_t RosMsgsDatagramConverter::convertMapDatagram2PointCloud(Poco::BinaryReade
 size_t RosMsgsDatagramConverter::convertClientGlobalAlignVisualizationDatagram2Message(
     const std::vector<char>& datagram,
     bosch_locator_bridge::ClientGlobalAlignVisualization& client_global_align_visualization,
-    geometry_msgs::PoseArray& poses, geometry_msgs::PoseArray& landmark_poses)
+    geometry_msgs::PoseArray& poses, geometry_msgs::PoseArray& landmark_poses, size_t max_datagram_size)
 {
-  Poco::MemoryInputStream inStream(&datagram[0], datagram.size());
+  Poco::MemoryInputStream inStream(datagram.data(), datagram.size());
   auto binary_reader = Poco::BinaryReader(inStream, Poco::BinaryReader::LITTLE_ENDIAN_BYTE_ORDER);
   binary_reader.setExceptions(std::ifstream::failbit | std::ifstream::badbit | std::ifstream::eofbit);
 
   double stamp;
   binary_reader >> stamp;
-  client_global_align_visualization.timestamp = ros::Time(stamp);
+  client_global_align_visualization.timestamp = toTime(stamp);
   binary_reader >> client_global_align_visualization.visualization_id;
 
   // Retrieve poses
@@ -123,6 +133,8 @@ size_t RosMsgsDatagramConverter::convertClientGlobalAlignVisualizationDatagram2M
   binary_reader >> num_poses;
   poses.header.stamp = client_global_align_visualization.timestamp;
   poses.header.frame_id = MAP_FRAME_ID;
+  checkAvailable(binary_reader, num_poses, 3 * 4, max_datagram_size);
+  poses.poses.reserve(num_poses);
   for (unsigned int i = 0; i < num_poses; i++)
   {
     geometry_msgs::Pose pose;
@@ -135,6 +147,10 @@ size_t RosMsgsDatagramConverter::convertClientGlobalAlignVisualizationDatagram2M
   binary_reader >> num_landmarks;
   landmark_poses.header.stamp = client_global_align_visualization.timestamp;
   landmark_poses.header.frame_id = MAP_FRAME_ID;
+  // each landmark has at least a pose, type, orientation flag and name length
+  checkAvailable(binary_reader, num_landmarks, 3 * 4 + 8 + 1 + 4, max_datagram_size);
+  landmark_poses.poses.reserve(num_landmarks);
+  client_global_align_visualization.landmarks.reserve(num_landmarks);
   for (unsigned int i = 0; i < num_landmarks; i++)
   {
     geometry_msgs::Pose pose;
@@ -149,12 +165,8 @@ size_t RosMsgsDatagramConverter::convertClientGlobalAlignVisualizationDatagram2M
 
     uint32_t name_length;
     binary_reader >> name_length;
-    std::vector<char> name(name_length);
-    for (unsigned int j = 0; j < name_length; j++)
-    {
-      binary_reader >> name[j];
-    }
-    vis_info.name = std::string(name.begin(), name.end());
+    checkAvailable(binary_reader, name_length, 1, max_datagram_size);
+    binary_reader.readRaw(name_length, vis_info.name);
 
     client_global_align_visualization.landmarks.push_back(vis_info);
   }
@@ -162,6 +174,8 @@ size_t RosMsgsDatagramConverter::convertClientGlobalAlignVisualizationDatagram2M
   // retrieve observations
   uint32_t num_observations;
   binary_reader >> num_observations;
+  checkAvailable(binary_reader, num_observations, 2 * 4, max_datagram_size);
+  client_global_align_visualization.observations.reserve(num_observations);
   for (unsigned int i = 0; i < num_observations; i++)
   {
     bosch_locator_bridge::ClientGlobalAlignLandmarkObservationNotice notice;
@@ -175,14 +189,14 @@ size_t RosMsgsDatagramConverter::convertClientLocalizationPoseDatagram2Message(
     const std::vector<char>& datagram, bosch_locator_bridge::ClientLocalizationPose& client_localization_pose,
     geometry_msgs::PoseStamped& pose, double covariance[6], geometry_msgs::PoseStamped& lidar_odo_pose)
 {
-  Poco::MemoryInputStream inStream(&datagram[0], datagram.size());
+  Poco::MemoryInputStream inStream(datagram.data(), datagram.size());
   auto binary_reader = Poco::BinaryReader(inStream, Poco::BinaryReader::LITTLE_ENDIAN_BYTE_ORDER);
   binary_reader.setExceptions(std::ifstream::failbit | std::ifstream::badbit | std::ifstream::eofbit);
 
   double age, stamp;
   binary_reader >> age >> stamp;
-  client_localization_pose.age = ros::Duration(age);
-  client_localization_pose.timestamp = ros::Time(stamp);
+  client_localization_pose.age = toDuration(age);
+  client_localization_pose.timestamp = toTime(stamp);
   binary_reader >> client_localization_pose.unique_id >> client_localization_pose.state;
   binary_reader >> client_localization_pose.errorFlags >> client_localization_pose.infoFlags;
 
@@ -214,15 +228,15 @@ size_t RosMsgsDatagramConverter::convertClientLocalizationPoseDatagram2Message(
 size_t RosMsgsDatagramConverter::convertClientLocalizationVisualizationDatagram2Message(
     const std::vector<char>& datagram,
     bosch_locator_bridge::ClientLocalizationVisualization& client_localization_visualization,
-    geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan)
+    geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan, size_t max_datagram_size)
 {
-  Poco::MemoryInputStream inStream(&datagram[0], datagram.size());
+  Poco::MemoryInputStream inStream(datagram.data(), datagram.size());
   auto binary_reader = Poco::BinaryReader(inStream, Poco::BinaryReader::LITTLE_ENDIAN_BYTE_ORDER);
   binary_reader.setExceptions(std::ifstream::failbit | std::ifstream::badbit | std::ifstream::eofbit);
 
   double stamp;
   binary_reader >> stamp;
-  client_localization_visualization.timestamp = ros::Time(stamp);
+  client_localization_visualization.timestamp = toTime(stamp);
   binary_reader >> client_localization_visualization.unique_id >> client_localization_visualization.loc_state;
 
   // Get pose
@@ -232,14 +246,14 @@ size_t RosMsgsDatagramConverter::convertClientLocalizationVisualizationDatagram2
 
   binary_reader >> client_localization_visualization.delay;
   pcl::PointCloud<pcl::PointXYZRGB> point_cloud;
-  convertMapDatagram2PointCloud(binary_reader, point_cloud);
+  convertMapDatagram2PointCloud(binary_reader, point_cloud, max_datagram_size);
 
   // Get sensor offsets and read intensities
-  std::vector<uint64_t> sensor_offsets = readSensorOffsets(binary_reader);
-  readIntensities(binary_reader);
+  std::vector<uint64_t> sensor_offsets = readSensorOffsets(binary_reader, max_datagram_size);
+  readIntensities(binary_reader, max_datagram_size);
 
   // Discard the extension part of the datagram
-  discardExtension(binary_reader);
+  discardExtension(binary_reader, max_datagram_size);
 
   // Use sensor offsets to colorize point cloud
   colorizePointCloud(point_cloud, sensor_offsets);
@@ -254,14 +268,15 @@ size_t RosMsgsDatagramConverter::convertClientLocalizationVisualizationDatagram2
 
 size_t RosMsgsDatagramConverter::convertClientMapVisualizationDatagram2Message(
     const std::vector<char>& datagram, bosch_locator_bridge::ClientMapVisualization& client_map_visualization,
-    geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan, geometry_msgs::PoseArray& path_poses)
+    geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan, geometry_msgs::PoseArray& path_poses,
+    size_t max_datagram_size)
 {
-  Poco::MemoryInputStream inStream(&datagram[0], datagram.size());
+  Poco::MemoryInputStream inStream(datagram.data(), datagram.size());
   auto binary_reader = Poco::BinaryReader(inStream, Poco::BinaryReader::LITTLE_ENDIAN_BYTE_ORDER);
   binary_reader.setExceptions(std::ifstream::failbit | std::ifstream::badbit | std::ifstream::eofbit);
   double stamp;
   binary_reader >> stamp;
-  client_map_visualization.timestamp = ros::Time(stamp);
+  client_map_visualization.timestamp = toTime(stamp);
   binary_reader >> client_map_visualization.visualization_id >> client_map_visualization.status;
 
   // Get pose
@@ -272,14 +287,16 @@ size_t RosMsgsDatagramConverter::convertClientMapVisualizationDatagram2Message(
   binary_reader >> client_map_visualization.distanceToLastLC >> client_map_visualization.delay >>
       client_map_visualization.progress;
   pcl::PointCloud<pcl::PointXYZRGB> point_cloud;
-  convertMapDatagram2PointCloud(binary_reader, point_cloud);
+  convertMapDatagram2PointCloud(binary_reader, point_cloud, max_datagram_size);
 
   // Get path poses
   path_poses.header.stamp = client_map_visualization.timestamp;
   path_poses.header.frame_id = MAP_FRAME_ID;
   uint32_t path_poses_length;
   binary_reader >> path_poses_length;
+  checkAvailable(binary_reader, path_poses_length, 3 * 4, max_datagram_size);
 
+  path_poses.poses.reserve(path_poses_length);
   for (unsigned int i = 0; i < path_poses_length; i++)
   {
     geometry_msgs::Pose nextPose;
@@ -290,6 +307,7 @@ size_t RosMsgsDatagramConverter::convertClientMapVisualizationDatagram2Message(
   // Get path types
   uint32_t path_types_length;
   binary_reader >> path_types_length;
+  checkAvailable(binary_reader, path_types_length, 4, max_datagram_size);
 
   client_map_visualization.path_types.resize(path_types_length);
   for (unsigned int i = 0; i < path_types_length; i++)
@@ -298,11 +316,11 @@ size_t RosMsgsDatagramConverter::convertClientMapVisualizationDatagram2Message(
   }
 
   // Get sensor offsets and read intensities
-  std::vector<uint64_t> sensor_offsets = readSensorOffsets(binary_reader);
-  readIntensities(binary_reader);
+  std::vector<uint64_t> sensor_offsets = readSensorOffsets(binary_reader, max_datagram_size);
+  readIntensities(binary_reader, max_datagram_size);
 
   // Discard the extension part of the datagram
-  discardExtension(binary_reader);
+  discardExtension(binary_reader, max_datagram_size);
 
   // Use sensor offsets to colorize point cloud
   colorizePointCloud(point_cloud, sensor_offsets);
@@ -318,15 +336,16 @@ size_t RosMsgsDatagramConverter::convertClientMapVisualizationDatagram2Message(
 size_t RosMsgsDatagramConverter::convertClientRecordingVisualizationDatagram2Message(
     const std::vector<char>& datagram,
     bosch_locator_bridge::ClientRecordingVisualization& client_recording_visualization,
-    geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan, geometry_msgs::PoseArray& path_poses)
+    geometry_msgs::PoseStamped& pose, sensor_msgs::PointCloud2& scan, geometry_msgs::PoseArray& path_poses,
+    size_t max_datagram_size)
 {
-  Poco::MemoryInputStream inStream(&datagram[0], datagram.size());
+  Poco::MemoryInputStream inStream(datagram.data(), datagram.size());
   auto binary_reader = Poco::BinaryReader(inStream, Poco::BinaryReader::LITTLE_ENDIAN_BYTE_ORDER);
   binary_reader.setExceptions(std::ifstream::failbit | std::ifstream::badbit | std::ifstream::eofbit);
 
   double stamp;
   binary_reader >> stamp;
-  client_recording_visualization.timestamp = ros::Time(stamp);
+  client_recording_visualization.timestamp = toTime(stamp);
   binary_reader >> client_recording_visualization.visualization_id >> client_recording_visualization.status;
 
   // Get pose
@@ -337,14 +356,16 @@ size_t RosMsgsDatagramConverter::convertClientRecordingVisualizationDatagram2Mes
   binary_reader >> client_recording_visualization.distanceToLastLC >> client_recording_visualization.delay >>
       client_recording_visualization.progress;
   pcl::PointCloud<pcl::PointXYZRGB> point_cloud;
-  convertMapDatagram2PointCloud(binary_reader, point_cloud);
+  convertMapDatagram2PointCloud(binary_reader, point_cloud, max_datagram_size);
 
   // Get path poses
   path_poses.header.stamp = client_recording_visualization.timestamp;
   path_poses.header.frame_id = MAP_FRAME_ID;
   uint32_t path_poses_length;
   binary_reader >> path_poses_length;
+  checkAvailable(binary_reader, path_poses_length, 3 * 4, max_datagram_size);
 
+  path_poses.poses.reserve(path_poses_length);
   for (unsigned int i = 0; i < path_poses_length; i++)
   {
     geometry_msgs::Pose nextPose;
@@ -355,6 +376,7 @@ size_t RosMsgsDatagramConverter::convertClientRecordingVisualizationDatagram2Mes
   // Get path types
   uint32_t path_types_length;
   binary_reader >> path_types_length;
+  checkAvailable(binary_reader, path_types_length, 4, max_datagram_size);
 
   client_recording_visualization.path_types.resize(path_types_length);
   for (unsigned int i = 0; i < path_types_length; i++)
@@ -363,11 +385,11 @@ size_t RosMsgsDatagramConverter::convertClientRecordingVisualizationDatagram2Mes
   }
 
   // Get sensor offsets and read intensities
-  std::vector<uint64_t> sensor_offsets = readSensorOffsets(binary_reader);
-  readIntensities(binary_reader);
+  std::vector<uint64_t> sensor_offsets = readSensorOffsets(binary_reader, max_datagram_size);
+  readIntensities(binary_reader, max_datagram_size);
 
   // Discard the extension part of the datagram
-  discardExtension(binary_reader);
+  discardExtension(binary_reader, max_datagram_size);
 
   // Use sensor offsets to colorize point cloud
   colorizePointCloud(point_cloud, sensor_offsets);
@@ -535,8 +557,14 @@ Poco::JSON::Object RosMsgsDatagramConverter::makePose2d(const geometry_msgs::Pos
 void RosMsgsDatagramConverter::colorizePointCloud(pcl::PointCloud<pcl::PointXYZRGB>& point_cloud,
                                                   const std::vector<uint64_t>& sensor_offsets)
 {
-  for (unsigned int i = sensor_offsets[0];
-    i < (sensor_offsets.size() == 2 ? sensor_offsets[1] : point_cloud.size()); i++)
+  if (sensor_offsets.empty())
+  {
+    return;
+  }
+  // the offsets are read from the datagram, so they are not necessarily within the point cloud
+  const uint64_t first_end =
+      std::min<uint64_t>(sensor_offsets.size() == 2 ? sensor_offsets[1] : point_cloud.size(), point_cloud.size());
+  for (uint64_t i = sensor_offsets[0]; i < first_end; i++)
   {
     point_cloud[i].r = 239;
     point_cloud[i].g = 41;
@@ -544,7 +572,7 @@ void RosMsgsDatagramConverter::colorizePointCloud(pcl::PointCloud<pcl::PointXYZR
   }
   if (sensor_offsets.size() == 2)
   {
-    for (unsigned int i = sensor_offsets[1]; i < point_cloud.size(); i++)
+    for (uint64_t i = sensor_offsets[1]; i < point_cloud.size(); i++)
     {
       point_cloud[i].r = 114;
       point_cloud[i].g = 159;
@@ -553,12 +581,18 @@ void RosMsgsDatagramConverter::colorizePointCloud(pcl::PointCloud<pcl::PointXYZR
   }
 }
 
-size_t RosMsgsDatagramConverter::discardExtension(Poco::BinaryReader& binary_reader)
+size_t RosMsgsDatagramConverter::discardExtension(Poco::BinaryReader& binary_reader, size_t max_datagram_size)
 {
   uint32_t extensionSize {0u};
   binary_reader >> extensionSize;
 
+  // the extension size includes the size field itself
+  if (extensionSize < 4u)
+  {
+    throw CorruptDatagramError("invalid datagram extension size " + std::to_string(extensionSize));
+  }
   const auto bytesToDiscard = extensionSize - 4u;
+  checkAvailable(binary_reader, bytesToDiscard, 1, max_datagram_size);
   std::vector<char> dataToDiscard(bytesToDiscard);
 
   binary_reader.readRaw(dataToDiscard.data(), bytesToDiscard);
@@ -566,12 +600,13 @@ size_t RosMsgsDatagramConverter::discardExtension(Poco::BinaryReader& binary_rea
   return extensionSize;
 }
 
-void RosMsgsDatagramConverter::readIntensities(Poco::BinaryReader& binary_reader)
+void RosMsgsDatagramConverter::readIntensities(Poco::BinaryReader& binary_reader, size_t max_datagram_size)
 {
   bool has_intensities;
   float min_intensity, max_intensity;
   uint32_t intensities_length;
   binary_reader >> has_intensities >> min_intensity >> max_intensity >> intensities_length;
+  checkAvailable(binary_reader, intensities_length, 4, max_datagram_size);
 
   std::vector<float> intensities(intensities_length);
   for (unsigned int i = 0; i < intensities_length; i++)
@@ -580,10 +615,12 @@ void RosMsgsDatagramConverter::readIntensities(Poco::BinaryReader& binary_reader
   }
 }
 
-std::vector<uint64_t> RosMsgsDatagramConverter::readSensorOffsets(Poco::BinaryReader& binary_reader)
+std::vector<uint64_t> RosMsgsDatagramConverter::readSensorOffsets(Poco::BinaryReader& binary_reader,
+                                                                  size_t max_datagram_size)
 {
   uint32_t sensor_offsets_length;
   binary_reader >> sensor_offsets_length;
+  checkAvailable(binary_reader, sensor_offsets_length, 8, max_datagram_size);
 
   std::vector<uint64_t> sensor_offsets(sensor_offsets_length);
   for (unsigned int i = 0; i < sensor_offsets_length; i++)
@@ -593,3 +630,51 @@ std::vector<uint64_t> RosMsgsDatagramConverter::readSensorOffsets(Poco::BinaryRe
 
   return sensor_offsets;
 }
+
+void RosMsgsDatagramConverter::checkAvailable(Poco::BinaryReader& binary_reader, uint64_t num_elements,
+                                              size_t element_size, size_t max_datagram_size)
+{
+  // num_elements is read as uint32_t, so this cannot overflow
+  const uint64_t required_bytes = num_elements * element_size;
+  if (required_bytes > max_datagram_size)
+  {
+    throw CorruptDatagramError("datagram length field of " + std::to_string(num_elements) + " elements exceeds " +
+                               std::to_string(max_datagram_size) + " bytes");
+  }
+  if (required_bytes > static_cast<uint64_t>(std::max<std::streamsize>(0, binary_reader.available())))
+  {
+    throw std::ios_base::failure("datagram not yet completely received");
+  }
+}
+
+ros::Time RosMsgsDatagramConverter::toTime(double seconds)
+{
+  if (!std::isfinite(seconds))
+  {
+    throw CorruptDatagramError("invalid datagram timestamp " + std::to_string(seconds));
+  }
+  try
+  {
+    return ros::Time(seconds);
+  }
+  catch (const std::runtime_error& error)
+  {
+    throw CorruptDatagramError(std::string("invalid datagram timestamp: ") + error.what());
+  }
+}
+
+ros::Duration RosMsgsDatagramConverter::toDuration(double seconds)
+{
+  if (!std::isfinite(seconds))
+  {
+    throw CorruptDatagramError("invalid datagram duration " + std::to_string(seconds));
+  }
+  try
+  {
+    return ros::Duration(seconds);
+  }
+  catch (const std::runtime_error& error)
+  {
+    throw CorruptDatagramError(std::string("invalid datagram duration: ") + error.what());
+  }
+}
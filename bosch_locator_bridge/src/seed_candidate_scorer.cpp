@@ -0,0 +1,364 @@
+// Copyright (c) 2021 - for information on the respective copyright owner
+// see the NOTICE file and/or the repository https://github.com/boschglobal/locator_ros_bridge.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "seed_candidate_scorer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <thread>
+
+#include <angles/angles.h>
+#include <ros/ros.h>
+#include <sensor_msgs/point_cloud2_iterator.h>
+#include <tf2/utils.h>
+
+/// upper bound for the number of cells of the distance transform. The resolution is coarsened for larger maps.
+static constexpr double MAX_GRID_CELLS = 4e6;
+
+/// value of a cell without map point in the squared distance transform (needs to be finite, see below)
+static constexpr float UNOCCUPIED = 1e20f;
+
+/**
+ * One dimensional squared euclidean distance transform of a sampled function, see
+ * P. Felzenszwalb, D. Huttenlocher: Distance Transforms of Sampled Functions.
+ * v and z are scratch buffers of size n and n + 1.
+ */
+static void distanceTransform1D(const double* f, double* d, int n, int* v, double* z)
+{
+  int k = 0;
+  v[0] = 0;
+  z[0] = -UNOCCUPIED;
+  z[1] = UNOCCUPIED;
+  for (int q = 1; q < n; q++)
+  {
+    double s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+    while (s <= z[k])
+    {
+      k--;
+      s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+    }
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = UNOCCUPIED;
+  }
+
+  k = 0;
+  for (int q = 0; q < n; q++)
+  {
+    while (z[k + 1] < q)
+    {
+      k++;
+    }
+    d[q] = (q - v[k]) * static_cast<double>(q - v[k]) + f[v[k]];
+  }
+}
+
+SeedCandidateScorer::SeedCandidateScorer(const Parameters& parameters)
+  : parameters_(parameters), worker_(&SeedCandidateScorer::runDistanceGridWorker, this)
+{
+}
+
+SeedCandidateScorer::~SeedCandidateScorer()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_worker_ = true;
+  }
+  worker_cv_.notify_all();
+  worker_.join();
+}
+
+void SeedCandidateScorer::setMap(const sensor_msgs::PointCloud2& map)
+{
+  auto points = std::make_shared<std::vector<Point>>(readPoints(map));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // the distance transform of the previous map must not be used for the new one
+    grid_.reset();
+    pending_map_points_ = points;
+  }
+  worker_cv_.notify_all();
+}
+
+void SeedCandidateScorer::runDistanceGridWorker()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    worker_cv_.wait(lock, [this]() { return stop_worker_ || pending_map_points_; });
+    if (stop_worker_)
+    {
+      return;
+    }
+    const auto points = pending_map_points_;
+    pending_map_points_.reset();
+    lock.unlock();
+
+    const auto start = ros::WallTime::now();
+    auto grid = computeDistanceGrid(*points, parameters_);
+    if (grid)
+    {
+      ROS_INFO_STREAM("seed candidate scoring: distance transform of "
+                      << grid->width << "x" << grid->height << " cells computed in "
+                      << (ros::WallTime::now() - start).toSec() << "s");
+    }
+
+    lock.lock();
+    // only use the grid if no newer map has been set meanwhile
+    if (!pending_map_points_)
+    {
+      grid_ = grid;
+    }
+  }
+}
+
+void SeedCandidateScorer::setScan(const geometry_msgs::Pose& pose, const sensor_msgs::PointCloud2& scan)
+{
+  const auto points = readPoints(scan);
+  if (points.empty())
+  {
+    return;
+  }
+
+  // transform the scan points from map frame into the frame of the pose they were observed from
+  const double yaw = tf2::getYaw(pose.orientation);
+  const double c = std::cos(yaw);
+  const double s = std::sin(yaw);
+  const size_t max_points = std::max(1, parameters_.max_scan_points);
+  const double step = std::max(1.0, static_cast<double>(points.size()) / max_points);
+
+  auto relative_points = std::make_shared<std::vector<Point>>();
+  relative_points->reserve(std::min(points.size(), max_points));
+  for (double i = 0.0; i < points.size(); i += step)
+  {
+    const auto& p = points[static_cast<size_t>(i)];
+    const double dx = p.x - pose.position.x;
+    const double dy = p.y - pose.position.y;
+    relative_points->push_back({ c * dx + s * dy, -s * dx + c * dy });
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  scan_ = relative_points;
+}
+
+std::vector<SeedCandidateScorer::Candidate>
+SeedCandidateScorer::scoreCandidates(const geometry_msgs::Pose2D& seed, size_t max_candidates) const
+{
+  std::shared_ptr<const DistanceGrid> grid;
+  std::shared_ptr<const std::vector<Point>> scan;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    grid = grid_;
+    scan = scan_;
+  }
+  std::vector<Candidate> candidates;
+  if (!grid || !scan)
+  {
+    return candidates;
+  }
+
+  // sample candidates on a regular grid around the seed (including the seed itself)
+  const int linear_steps =
+      parameters_.linear_step > 0.0 ? static_cast<int>(parameters_.linear_range / parameters_.linear_step) : 0;
+  const int angular_steps =
+      parameters_.angular_step > 0.0 ? static_cast<int>(parameters_.angular_range / parameters_.angular_step) : 0;
+  for (int ix = -linear_steps; ix <= linear_steps; ix++)
+  {
+    for (int iy = -linear_steps; iy <= linear_steps; iy++)
+    {
+      for (int ia = -angular_steps; ia <= angular_steps; ia++)
+      {
+        Candidate candidate;
+        candidate.pose.x = seed.x + ix * parameters_.linear_step;
+        candidate.pose.y = seed.y + iy * parameters_.linear_step;
+        candidate.pose.theta = angles::normalize_angle(seed.theta + ia * parameters_.angular_step);
+        candidate.score = 0.0;
+        candidates.push_back(candidate);
+      }
+    }
+  }
+
+  // score the candidates in parallel, each worker takes an interleaved share of them
+  const size_t num_workers =
+      std::max(1u, std::min(std::thread::hardware_concurrency(), static_cast<unsigned int>(candidates.size())));
+  std::vector<std::future<void>> workers;
+  for (size_t w = 0; w < num_workers; w++)
+  {
+    workers.push_back(std::async(std::launch::async, [&, w]() {
+      for (size_t i = w; i < candidates.size(); i += num_workers)
+      {
+        candidates[i].score = scoreCandidate(*grid, *scan, candidates[i].pose, parameters_.max_distance);
+      }
+    }));
+  }
+  for (auto& worker : workers)
+  {
+    worker.get();
+  }
+
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const Candidate& a, const Candidate& b) { return a.score < b.score; });
+
+  // the score changes smoothly with the pose, so the next best candidates are usually neighbors of the best one.
+  // Suppress candidates close to a better one, so that each returned candidate is a different hypothesis
+  const double linear_radius = parameters_.linear_range / 2.0;
+  const double angular_radius = parameters_.angular_range / 2.0;
+  std::vector<Candidate> selected;
+  for (const auto& candidate : candidates)
+  {
+    if (selected.size() >= max_candidates)
+    {
+      break;
+    }
+    const bool suppressed = std::any_of(selected.begin(), selected.end(), [&](const Candidate& better) {
+      return std::hypot(candidate.pose.x - better.pose.x, candidate.pose.y - better.pose.y) <= linear_radius &&
+             std::fabs(angles::shortest_angular_distance(candidate.pose.theta, better.pose.theta)) <= angular_radius;
+    });
+    if (!suppressed)
+    {
+      selected.push_back(candidate);
+    }
+  }
+  return selected;
+}
+
+std::vector<SeedCandidateScorer::Point> SeedCandidateScorer::readPoints(const sensor_msgs::PointCloud2& cloud)
+{
+  std::vector<Point> points;
+  if (cloud.width * cloud.height == 0)
+  {
+    return points;
+  }
+  points.reserve(cloud.width * cloud.height);
+  sensor_msgs::PointCloud2ConstIterator<float> iter_x(cloud, "x");
+  sensor_msgs::PointCloud2ConstIterator<float> iter_y(cloud, "y");
+  for (; iter_x != iter_x.end(); ++iter_x, ++iter_y)
+  {
+    if (std::isfinite(*iter_x) && std::isfinite(*iter_y))
+    {
+      points.push_back({ *iter_x, *iter_y });
+    }
+  }
+  return points;
+}
+
+std::shared_ptr<const SeedCandidateScorer::DistanceGrid>
+SeedCandidateScorer::computeDistanceGrid(const std::vector<Point>& points, const Parameters& parameters)
+{
+  if (points.empty() || parameters.grid_resolution <= 0.0)
+  {
+    return nullptr;
+  }
+
+  double min_x = points[0].x, max_x = points[0].x;
+  double min_y = points[0].y, max_y = points[0].y;
+  for (const auto& p : points)
+  {
+    min_x = std::min(min_x, p.x);
+    max_x = std::max(max_x, p.x);
+    min_y = std::min(min_y, p.y);
+    max_y = std::max(max_y, p.y);
+  }
+  // candidates close to the border of the map should still see the full distance gradient
+  const double margin = parameters.max_distance;
+  min_x -= margin;
+  min_y -= margin;
+  max_x += margin;
+  max_y += margin;
+
+  double resolution = parameters.grid_resolution;
+  const double area = (max_x - min_x) * (max_y - min_y);
+  if (area / (resolution * resolution) > MAX_GRID_CELLS)
+  {
+    resolution = std::sqrt(area / MAX_GRID_CELLS);
+    ROS_WARN_STREAM("seed candidate scoring: map too large, using a distance transform resolution of " << resolution
+                                                                                                      << "m");
+  }
+
+  auto grid = std::make_shared<DistanceGrid>();
+  grid->origin_x = min_x;
+  grid->origin_y = min_y;
+  grid->resolution = resolution;
+  grid->width = static_cast<int>(std::ceil((max_x - min_x) / resolution)) + 1;
+  grid->height = static_cast<int>(std::ceil((max_y - min_y) / resolution)) + 1;
+
+  // squared distance transform in cells, computed separably: first along the columns, then along the rows
+  const int width = grid->width;
+  const int height = grid->height;
+  std::vector<float> squared(static_cast<size_t>(width) * height, UNOCCUPIED);
+  for (const auto& p : points)
+  {
+    const int cx = static_cast<int>((p.x - min_x) / resolution);
+    const int cy = static_cast<int>((p.y - min_y) / resolution);
+    squared[static_cast<size_t>(cy) * width + cx] = 0.0;
+  }
+
+  const int n = std::max(width, height);
+  std::vector<double> f(n), d(n), z(n + 1);
+  std::vector<int> v(n);
+  for (int x = 0; x < width; x++)
+  {
+    for (int y = 0; y < height; y++)
+    {
+      f[y] = squared[static_cast<size_t>(y) * width + x];
+    }
+    distanceTransform1D(f.data(), d.data(), height, v.data(), z.data());
+    for (int y = 0; y < height; y++)
+    {
+      squared[static_cast<size_t>(y) * width + x] = static_cast<float>(d[y]);
+    }
+  }
+
+  grid->distances.resize(squared.size());
+  for (int y = 0; y < height; y++)
+  {
+    const size_t row = static_cast<size_t>(y) * width;
+    std::copy(squared.begin() + row, squared.begin() + row + width, f.begin());
+    distanceTransform1D(f.data(), d.data(), width, v.data(), z.data());
+    for (int x = 0; x < width; x++)
+    {
+      grid->distances[row + x] =
+          static_cast<float>(std::min(std::sqrt(d[x]) * resolution, parameters.max_distance));
+    }
+  }
+
+  return grid;
+}
+
+double SeedCandidateScorer::scoreCandidate(const DistanceGrid& grid, const std::vector<Point>& scan,
+                                           const geometry_msgs::Pose2D& pose, double max_distance)
+{
+  const double c = std::cos(pose.theta);
+  const double s = std::sin(pose.theta);
+  double sum = 0.0;
+  for (const auto& p : scan)
+  {
+    const double x = pose.x + c * p.x - s * p.y;
+    const double y = pose.y + s * p.x + c * p.y;
+    const int cx = static_cast<int>(std::floor((x - grid.origin_x) / grid.resolution));
+    const int cy = static_cast<int>(std::floor((y - grid.origin_y) / grid.resolution));
+    if (cx < 0 || cy < 0 || cx >= grid.width || cy >= grid.height)
+    {
+      sum += max_distance;
+    }
+    else
+    {
+      sum += grid.distances[static_cast<size_t>(cy) * grid.width + cx];
+    }
+  }
+  return scan.empty() ? max_distance : sum / scan.size();
+}
@@ -19,7 +19,8 @@
 
 #include <Poco/Net/NetException.h>
 
-SendingInterface::SendingInterface(uint16_t port) : socket_(port), running_(true)
+SendingInterface::SendingInterface(uint16_t port, size_t replay_buffer_size, double replay_max_age)
+  : socket_(port), running_(true), replay_buffer_size_(replay_buffer_size), replay_max_age_(replay_max_age)
 {
   // configure server socket same as binary interface example
   socket_.setKeepAlive(true);
@@ -40,8 +41,12 @@ void SendingInterface::run()
         ROS_INFO_STREAM("accepted connection from " << clientAddr << " at " << sock.address().toString());
         sock.setNoDelay(true);
         {
+          // replay while holding the lock, so that no live data is sent in between
           std::lock_guard<std::mutex> lock(connections_mutex_);
-          connections_.push_back(sock);
+          if (replay(sock))
+          {
+            connections_.push_back(sock);
+          }
         }
       }
       catch (const Poco::Exception& e)
@@ -73,17 +78,7 @@ SendingInterface::SendingStatus SendingInterface::sendData(void* data, size_t si
   {
     try
     {
-      size_t total_sent = 0;
-      while (total_sent < size)
-      {
-        const auto sent = connections_[i].sendBytes(data, size);
-        if (sent <= 0)
-        {
-          break;
-        }
-        total_sent += sent;
-      }
-      if (total_sent == size)
+      if (sendCompletely(connections_[i], static_cast<const char*>(data), size))
       {
         good_connections.push_back(connections_[i]);
         ROS_INFO_STREAM_THROTTLE_NAMED(10, std::to_string(size),
@@ -112,9 +107,66 @@ SendingInterface::SendingStatus SendingInterface::sendData(void* data, size_t si
   }
   std::swap(connections_, good_connections);
 
+  if (replay_buffer_size_ > 0)
+  {
+    const auto bytes = static_cast<const char*>(data);
+    replay_buffer_.emplace_back(std::chrono::steady_clock::now(), std::vector<char>(bytes, bytes + size));
+    while (replay_buffer_.size() > replay_buffer_size_)
+    {
+      replay_buffer_.pop_front();
+    }
+  }
+
   return ret;
 }
 
+bool SendingInterface::sendCompletely(Poco::Net::StreamSocket& connection, const char* data, size_t size)
+{
+  size_t total_sent = 0;
+  while (total_sent < size)
+  {
+    const auto sent = connection.sendBytes(data + total_sent, size - total_sent);
+    if (sent <= 0)
+    {
+      break;
+    }
+    total_sent += sent;
+  }
+  return total_sent == size;
+}
+
+bool SendingInterface::replay(Poco::Net::StreamSocket& connection)
+{
+  const auto now = std::chrono::steady_clock::now();
+  size_t replayed = 0;
+  try
+  {
+    for (const auto& entry : replay_buffer_)
+    {
+      if (replay_max_age_.count() > 0.0 && now - entry.first > replay_max_age_)
+      {
+        continue;
+      }
+      if (!sendCompletely(connection, entry.second.data(), entry.second.size()))
+      {
+        ROS_ERROR_STREAM("could not replay datagram completely, discarding connection!");
+        return false;
+      }
+      replayed++;
+    }
+  }
+  catch (const Poco::Exception& e)
+  {
+    ROS_ERROR_STREAM("caught exception while replaying datagrams, discarding connection: " << e.displayText());
+    return false;
+  }
+  if (replayed > 0)
+  {
+    ROS_INFO_STREAM("replayed " << replayed << " datagrams to " << connection.peerAddress());
+  }
+  return true;
+}
+
 void SendingInterface::stop()
 {
   running_.store(false);